@@ -30,6 +30,7 @@ class SimulationParameters:
         position_interval=60.0,
         range=300.0,
         edt=True,
+        store_and_forward=False,
         mobility_file="./50_ues.tcl",
         lib_path="./build/lib",
     ):
@@ -41,6 +42,7 @@ class SimulationParameters:
         self.sync_frequency = sync_frequency  # in Seconds
         self.position_interval = position_interval  # in Seconds
         self.edt = edt  # If Early Data Transmission should be used
+        self.store_and_forward = store_and_forward  # Hold positions while out of coverage
         self.mobility_file = mobility_file
         self.lib_path = (
             lib_path  # Use this path instead of whatever LD_LIBRARY_PATH holds
@@ -59,6 +61,8 @@ class SimulationParameters:
         call += f" --syncFrequency={self.sync_frequency}"
         call += f" --edt={self.edt}"
         call += f" --mobilityFile={self.mobility_file}"
+        if self.store_and_forward:
+            call += " --storeAndForward=true"
         return call
 
 
@@ -149,6 +153,18 @@ for i in range(1, seed + 1):
             )
         )
 
+        # Cobertura com armazenamento das posições fora do alcance
+        if command != "checkpointing":
+            simu_queue.add_task(
+                SimulationParameters(
+                    sim_name=f"{command}_store_and_forward",
+                    simulation=f"./build/scratch/{command}",
+                    random_seed=i,
+                    range=500.0,
+                    store_and_forward=True,
+                )
+            )
+
         # Quantidade de Nós
         simu_queue.add_task(
             SimulationParameters(
@@ -179,6 +195,16 @@ for i in range(1, seed + 1):
             )
         )
 
+        # EDT sem preenchimento extra, para que os lotes caibam no bloco
+        simu_queue.add_task(
+            SimulationParameters(
+                sim_name=f"{command}_edt_block",
+                simulation=f"./build/scratch/{command}",
+                random_seed=i,
+                payload_size=0,
+            )
+        )
+
         # Frequência de Coleta de Dados de Rastreamento
         simu_queue.add_task(
             SimulationParameters(
@@ -0,0 +1,138 @@
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "adaptive-sampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("AdaptiveSampler");
+
+NS_OBJECT_ENSURE_REGISTERED(AdaptiveSampler);
+
+namespace {
+
+// Below this speed, in m/s, a vehicle counts as stopped and has no heading.
+const double kStoppedSpeed = 0.1;
+
+double GetSpeed(const Vector &velocity) {
+  return std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+}
+
+} // namespace
+
+TypeId AdaptiveSampler::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::AdaptiveSampler")
+    .SetParent<Object>()
+    .SetGroupName("Applications")
+    .AddConstructor<AdaptiveSampler>()
+    .AddAttribute("MinInterval",
+                   "Shortest time between fixes",
+                   TimeValue(Seconds(1.0)),
+                   MakeTimeAccessor(&AdaptiveSampler::m_minInterval),
+                   MakeTimeChecker())
+    .AddAttribute("MaxInterval",
+                   "Longest time between fixes, which a stopped vehicle takes",
+                   TimeValue(Seconds(30.0)),
+                   MakeTimeAccessor(&AdaptiveSampler::m_maxInterval),
+                   MakeTimeChecker())
+    .AddAttribute("Distance",
+                   "Meters the vehicle should travel between fixes",
+                   DoubleValue(20.0),
+                   MakeDoubleAccessor(&AdaptiveSampler::m_distance),
+                   MakeDoubleChecker<double>(0.0))
+    .AddAttribute("HeadingChange",
+                   "Degrees of turn at a course change that bring the next fix forward",
+                   DoubleValue(20.0),
+                   MakeDoubleAccessor(&AdaptiveSampler::m_headingChange),
+                   MakeDoubleChecker<double>(0.0, 180.0))
+  ;
+  return tid;
+}
+
+AdaptiveSampler::AdaptiveSampler()
+  : m_minInterval(Seconds(1.0)),
+    m_maxInterval(Seconds(30.0)),
+    m_distance(20.0),
+    m_headingChange(20.0),
+    m_fixes(0) {
+}
+
+AdaptiveSampler::~AdaptiveSampler() {
+}
+
+void AdaptiveSampler::DoDispose(void) {
+  Stop();
+  m_takeFix = MakeNullCallback<void>();
+  Object::DoDispose();
+}
+
+void AdaptiveSampler::Start(Ptr<MobilityModel> ue, Callback<void> takeFix) {
+  NS_LOG_FUNCTION(this);
+  Stop();
+  m_ue = ue;
+  m_takeFix = takeFix;
+  m_fixes = 0;
+  m_ue->TraceConnectWithoutContext("CourseChange", MakeCallback(&AdaptiveSampler::CourseChanged, this));
+  m_fixEvent = Simulator::ScheduleNow(&AdaptiveSampler::Fix, this);
+}
+
+void AdaptiveSampler::Stop(void) {
+  Simulator::Cancel(m_fixEvent);
+  if (m_ue != 0) {
+    m_ue->TraceDisconnectWithoutContext("CourseChange", MakeCallback(&AdaptiveSampler::CourseChanged, this));
+    m_ue = 0;
+  }
+}
+
+void AdaptiveSampler::CourseChanged(Ptr<const MobilityModel> model) {
+  NS_LOG_FUNCTION(this);
+  if (m_fixes == 0) {
+    return;
+  }
+
+  Vector velocity = m_ue->GetVelocity();
+  Time interval = GetInterval(velocity);
+
+  double speed = GetSpeed(velocity);
+  double lastSpeed = GetSpeed(m_lastVelocity);
+  if (speed >= kStoppedSpeed) {
+    if (lastSpeed < kStoppedSpeed) {
+      interval = m_minInterval;
+    } else {
+      double turn = std::atan2(velocity.y, velocity.x) - std::atan2(m_lastVelocity.y, m_lastVelocity.x);
+      if (std::fabs(std::remainder(turn, 2 * M_PI)) * 180.0 / M_PI >= m_headingChange) {
+        interval = m_minInterval;
+      }
+    }
+  }
+
+  // Only ever brought forward: a vehicle slowing down still takes the fix
+  // its previous speed called for.
+  Time at = std::max(m_lastFix + interval, Simulator::Now());
+  if (at.GetTimeStep() < m_fixEvent.GetTs()) {
+    Simulator::Cancel(m_fixEvent);
+    m_fixEvent = Simulator::Schedule(at - Simulator::Now(), &AdaptiveSampler::Fix, this);
+  }
+}
+
+void AdaptiveSampler::Fix(void) {
+  NS_LOG_FUNCTION(this);
+  m_lastFix = Simulator::Now();
+  m_lastVelocity = m_ue->GetVelocity();
+  ++m_fixes;
+  m_takeFix();
+  m_fixEvent = Simulator::Schedule(GetInterval(m_lastVelocity), &AdaptiveSampler::Fix, this);
+}
+
+Time AdaptiveSampler::GetInterval(Vector velocity) const {
+  double speed = GetSpeed(velocity);
+  if (speed < kStoppedSpeed) {
+    return m_maxInterval;
+  }
+  return std::min(std::max(Seconds(m_distance / speed), m_minInterval), m_maxInterval);
+}
+
+} // namespace ns3
@@ -0,0 +1,65 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/mobility-model.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/vector.h"
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * Schedules GPS fixes by how the vehicle moves instead of at a fixed pace.
+ *
+ * Fixes are spaced Distance meters apart at the current speed, within
+ * [MinInterval, MaxInterval], so a vehicle waiting at a light takes one
+ * every MaxInterval. A course change that turns the heading by
+ * HeadingChange degrees or more, or that sets a stopped vehicle moving,
+ * brings the next fix forward to MinInterval after the last one, so the
+ * turn still shows up in the trajectory.
+ */
+class AdaptiveSampler : public Object {
+public:
+  static TypeId GetTypeId(void);
+
+  AdaptiveSampler();
+  virtual ~AdaptiveSampler();
+
+  /**
+   * Takes a fix right away and then keeps calling takeFix until Stop.
+   */
+  void Start(Ptr<MobilityModel> ue, Callback<void> takeFix);
+  void Stop(void);
+
+protected:
+  virtual void DoDispose(void);
+
+private:
+  void CourseChanged(Ptr<const MobilityModel> model);
+  void Fix(void);
+  /**
+   * \return the time between fixes for a vehicle moving at this velocity
+   */
+  Time GetInterval(Vector velocity) const;
+
+  Time m_minInterval;
+  Time m_maxInterval;
+  double m_distance;
+  double m_headingChange;
+
+  Ptr<MobilityModel> m_ue;
+  Callback<void> m_takeFix;
+  EventId m_fixEvent;
+  Time m_lastFix;
+  Vector m_lastVelocity;
+  uint32_t m_fixes;  // taken since Start
+};
+
+} // namespace ns3
+
+#endif /* ADAPTIVE_SAMPLER_H */
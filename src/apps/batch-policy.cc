@@ -0,0 +1,289 @@
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "batch-policy.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("BatchPolicy");
+
+NS_OBJECT_ENSURE_REGISTERED(BatchPolicy);
+NS_OBJECT_ENSURE_REGISTERED(CountBatchPolicy);
+NS_OBJECT_ENSURE_REGISTERED(FreshCountBatchPolicy);
+NS_OBJECT_ENSURE_REGISTERED(AgeBatchPolicy);
+NS_OBJECT_ENSURE_REGISTERED(BytesBatchPolicy);
+NS_OBJECT_ENSURE_REGISTERED(DistanceBatchPolicy);
+NS_OBJECT_ENSURE_REGISTERED(HeadingBatchPolicy);
+
+namespace {
+
+double LegLength(const PositionSample &from, const PositionSample &to) {
+  double dx = to.x - from.x;
+  double dy = to.y - from.y;
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+} // namespace
+
+TypeId BatchPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::BatchPolicy")
+    .SetParent<Object>()
+    .SetGroupName("Applications")
+  ;
+  return tid;
+}
+
+BatchPolicy::BatchPolicy()
+  : m_count(0),
+    m_oldest(0) {
+}
+
+BatchPolicy::~BatchPolicy() {
+}
+
+void BatchPolicy::Add(const PositionSample &sample) {
+  if (m_count++ == 0) {
+    m_oldest = sample.timestamp;
+  }
+  DoAdd(sample);
+}
+
+void BatchPolicy::Clear(void) {
+  m_count = 0;
+  DoClear();
+}
+
+bool BatchPolicy::ShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const {
+  return DoShouldSend(now, nFixes, batchSize, packetSize);
+}
+
+bool BatchPolicy::NeedsSizes(void) const {
+  return false;
+}
+
+void BatchPolicy::DoAdd(const PositionSample &sample) {
+}
+
+void BatchPolicy::DoClear(void) {
+}
+
+TypeId CountBatchPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::CountBatchPolicy")
+    .SetParent<BatchPolicy>()
+    .SetGroupName("Applications")
+    .AddConstructor<CountBatchPolicy>()
+    .AddAttribute("Count",
+                   "Fixes to gather before sending",
+                   UintegerValue(10),
+                   MakeUintegerAccessor(&CountBatchPolicy::m_threshold),
+                   MakeUintegerChecker<uint32_t>(1))
+  ;
+  return tid;
+}
+
+CountBatchPolicy::CountBatchPolicy()
+  : m_threshold(10) {
+}
+
+bool CountBatchPolicy::DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const {
+  return nFixes >= m_threshold;
+}
+
+TypeId FreshCountBatchPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::FreshCountBatchPolicy")
+    .SetParent<BatchPolicy>()
+    .SetGroupName("Applications")
+    .AddConstructor<FreshCountBatchPolicy>()
+    .AddAttribute("Count",
+                   "New fixes to gather before sending",
+                   UintegerValue(10),
+                   MakeUintegerAccessor(&FreshCountBatchPolicy::m_threshold),
+                   MakeUintegerChecker<uint32_t>(1))
+  ;
+  return tid;
+}
+
+FreshCountBatchPolicy::FreshCountBatchPolicy()
+  : m_threshold(10) {
+}
+
+bool FreshCountBatchPolicy::DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const {
+  return GetNPending() >= m_threshold;
+}
+
+TypeId AgeBatchPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::AgeBatchPolicy")
+    .SetParent<BatchPolicy>()
+    .SetGroupName("Applications")
+    .AddConstructor<AgeBatchPolicy>()
+    .AddAttribute("MaxAge",
+                   "Age of the oldest pending fix at which to send",
+                   TimeValue(Seconds(60.0)),
+                   MakeTimeAccessor(&AgeBatchPolicy::m_maxAge),
+                   MakeTimeChecker())
+  ;
+  return tid;
+}
+
+AgeBatchPolicy::AgeBatchPolicy()
+  : m_maxAge(Seconds(60.0)) {
+}
+
+bool AgeBatchPolicy::DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const {
+  return GetNPending() > 0 && now - GetOldest() >= m_maxAge;
+}
+
+TypeId BytesBatchPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::BytesBatchPolicy")
+    .SetParent<BatchPolicy>()
+    .SetGroupName("Applications")
+    .AddConstructor<BytesBatchPolicy>()
+    .AddAttribute("Size",
+                   "Bytes of the transport block to fill, padding included",
+                   UintegerValue(2048),
+                   MakeUintegerAccessor(&BytesBatchPolicy::m_size),
+                   MakeUintegerChecker<uint32_t>(1))
+  ;
+  return tid;
+}
+
+BytesBatchPolicy::BytesBatchPolicy()
+  : m_size(2048) {
+}
+
+bool BytesBatchPolicy::NeedsSizes(void) const {
+  return true;
+}
+
+bool BytesBatchPolicy::DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const {
+  if (GetNPending() == 0 || nFixes == 0) {
+    return false;
+  }
+  // Rounded up, so a batch never overflows the block by waiting too long.
+  uint32_t perFix = (batchSize + nFixes - 1) / nFixes;
+  return packetSize + perFix > m_size;
+}
+
+TypeId DistanceBatchPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::DistanceBatchPolicy")
+    .SetParent<BatchPolicy>()
+    .SetGroupName("Applications")
+    .AddConstructor<DistanceBatchPolicy>()
+    .AddAttribute("Distance",
+                   "Meters travelled since the last fix sent at which to send",
+                   DoubleValue(500.0),
+                   MakeDoubleAccessor(&DistanceBatchPolicy::m_distance),
+                   MakeDoubleChecker<double>(0.0))
+  ;
+  return tid;
+}
+
+DistanceBatchPolicy::DistanceBatchPolicy()
+  : m_distance(500.0),
+    m_travelled(0),
+    m_hasLast(false) {
+}
+
+void DistanceBatchPolicy::DoAdd(const PositionSample &sample) {
+  if (m_hasLast) {
+    m_travelled += LegLength(m_last, sample);
+  }
+  m_last = sample;
+  m_hasLast = true;
+}
+
+void DistanceBatchPolicy::DoClear(void) {
+  // m_last stays, so the next batch counts from the last fix sent.
+  m_travelled = 0;
+}
+
+bool DistanceBatchPolicy::DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const {
+  return GetNPending() > 0 && m_travelled >= m_distance;
+}
+
+TypeId HeadingBatchPolicy::GetTypeId(void) {
+  static TypeId tid = TypeId("ns3::HeadingBatchPolicy")
+    .SetParent<BatchPolicy>()
+    .SetGroupName("Applications")
+    .AddConstructor<HeadingBatchPolicy>()
+    .AddAttribute("Angle",
+                   "Degrees the heading must turn from the one at the last send",
+                   DoubleValue(30.0),
+                   MakeDoubleAccessor(&HeadingBatchPolicy::m_angle),
+                   MakeDoubleChecker<double>(0.0, 180.0))
+    .AddAttribute("MinDistance",
+                   "Meters a leg must cover before its heading counts",
+                   DoubleValue(10.0),
+                   MakeDoubleAccessor(&HeadingBatchPolicy::m_minDistance),
+                   MakeDoubleChecker<double>(0.0))
+  ;
+  return tid;
+}
+
+HeadingBatchPolicy::HeadingBatchPolicy()
+  : m_angle(30.0),
+    m_minDistance(10.0),
+    m_hasAnchor(false),
+    m_hasHeading(false),
+    m_heading(0),
+    m_hasReference(false),
+    m_reference(0),
+    m_turn(0) {
+}
+
+void HeadingBatchPolicy::DoAdd(const PositionSample &sample) {
+  if (!m_hasAnchor) {
+    m_anchor = sample;
+    m_hasAnchor = true;
+    return;
+  }
+  if (LegLength(m_anchor, sample) < m_minDistance) {
+    return;
+  }
+
+  m_heading = std::atan2(sample.y - m_anchor.y, sample.x - m_anchor.x);
+  m_hasHeading = true;
+  m_anchor = sample;
+  if (!m_hasReference) {
+    m_reference = m_heading;
+    m_hasReference = true;
+  }
+
+  // Difference of the two headings, wrapped into [0, pi].
+  double turn = std::fabs(std::remainder(m_heading - m_reference, 2 * M_PI));
+  m_turn = std::max(m_turn, turn * 180.0 / M_PI);
+}
+
+void HeadingBatchPolicy::DoClear(void) {
+  if (m_hasHeading) {
+    m_reference = m_heading;
+    m_hasReference = true;
+  }
+  m_turn = 0;
+}
+
+bool HeadingBatchPolicy::DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const {
+  return GetNPending() > 0 && m_turn >= m_angle;
+}
+
+Ptr<BatchPolicy> CreateBatchPolicy(const std::string &name) {
+  if (name == "count") {
+    return CreateObject<CountBatchPolicy>();
+  } else if (name == "fresh") {
+    return CreateObject<FreshCountBatchPolicy>();
+  } else if (name == "age") {
+    return CreateObject<AgeBatchPolicy>();
+  } else if (name == "bytes") {
+    return CreateObject<BytesBatchPolicy>();
+  } else if (name == "distance") {
+    return CreateObject<DistanceBatchPolicy>();
+  } else if (name == "heading") {
+    return CreateObject<HeadingBatchPolicy>();
+  }
+  return 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,187 @@
+#ifndef BATCH_POLICY_H
+#define BATCH_POLICY_H
+
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "position-sample.h"
+
+#include <stdint.h>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * Decides when a position client wakes the radio to send what it gathered.
+ *
+ * The client hands every fix it takes to Add, asks ShouldSend on each
+ * Interval tick and calls Clear once it has sent. A policy keeps state
+ * about the fixes gathered since the last send, so every client needs its
+ * own instance. Only policies that NeedsSizes are handed the encoded
+ * sizes; the others are asked before the batch is encoded, with zeros.
+ */
+class BatchPolicy : public Object {
+public:
+  static TypeId GetTypeId(void);
+
+  BatchPolicy();
+  virtual ~BatchPolicy();
+
+  void Add(const PositionSample &sample);
+  void Clear(void);
+  /**
+   * \param now current simulation time
+   * \param nFixes fixes the packet would carry, older unacked ones included
+   * \param batchSize bytes of the encoded fixes
+   * \param packetSize bytes of the packet carrying them, padding included
+   * \return whether the batch should go now
+   */
+  bool ShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const;
+  /**
+   * \return whether ShouldSend looks at the encoded sizes, so the batch
+   * has to be encoded before asking
+   */
+  virtual bool NeedsSizes(void) const;
+
+  /**
+   * \return the number of fixes added since the last Clear
+   */
+  uint32_t GetNPending(void) const { return m_count; }
+
+protected:
+  /**
+   * \return when the oldest fix added since the last Clear was taken
+   */
+  Time GetOldest(void) const { return TimeStep(m_oldest); }
+
+private:
+  virtual void DoAdd(const PositionSample &sample);
+  virtual void DoClear(void);
+  virtual bool DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const = 0;
+
+  uint32_t m_count;
+  int64_t m_oldest;
+};
+
+/**
+ * Sends once the packet would carry Count fixes, which is what the clients
+ * always did with AmountPositionsToSend. Checkpointing counts the fixes
+ * still unacked, so it keeps resending a full backlog without new fixes.
+ */
+class CountBatchPolicy : public BatchPolicy {
+public:
+  static TypeId GetTypeId(void);
+  CountBatchPolicy();
+
+private:
+  virtual bool DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const;
+
+  uint32_t m_threshold;
+};
+
+/**
+ * Sends once Count fixes were taken since the last send, however many
+ * older ones are still unacked.
+ */
+class FreshCountBatchPolicy : public BatchPolicy {
+public:
+  static TypeId GetTypeId(void);
+  FreshCountBatchPolicy();
+
+private:
+  virtual bool DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const;
+
+  uint32_t m_threshold;
+};
+
+/**
+ * Sends once the oldest pending fix is MaxAge old, bounding how stale the
+ * server's view gets regardless of how the vehicle moves.
+ */
+class AgeBatchPolicy : public BatchPolicy {
+public:
+  static TypeId GetTypeId(void);
+  AgeBatchPolicy();
+
+private:
+  virtual bool DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const;
+
+  Time m_maxAge;
+};
+
+/**
+ * Sends once the packet is so full that one more fix, at the average size
+ * of those already in it, would not fit in a transport block of Size bytes.
+ * A radio wake-up then carries as many fixes as the block allows.
+ */
+class BytesBatchPolicy : public BatchPolicy {
+public:
+  static TypeId GetTypeId(void);
+  BytesBatchPolicy();
+
+  virtual bool NeedsSizes(void) const;
+
+private:
+  virtual bool DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const;
+
+  uint32_t m_size;
+};
+
+/**
+ * Sends once the vehicle has travelled Distance meters along its fixes
+ * since the last fix sent, so a parked vehicle stays quiet and a fast one
+ * reports often.
+ */
+class DistanceBatchPolicy : public BatchPolicy {
+public:
+  static TypeId GetTypeId(void);
+  DistanceBatchPolicy();
+
+private:
+  virtual void DoAdd(const PositionSample &sample);
+  virtual void DoClear(void);
+  virtual bool DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const;
+
+  double m_distance;
+  double m_travelled;
+  bool m_hasLast;
+  PositionSample m_last;
+};
+
+/**
+ * Sends once the heading has turned Angle degrees away from the heading at
+ * the last send, which is when extrapolating from the last fix the server
+ * has stops working. Headings are taken over legs of at least MinDistance
+ * meters, so GPS jitter at low speed does not look like turning.
+ */
+class HeadingBatchPolicy : public BatchPolicy {
+public:
+  static TypeId GetTypeId(void);
+  HeadingBatchPolicy();
+
+private:
+  virtual void DoAdd(const PositionSample &sample);
+  virtual void DoClear(void);
+  virtual bool DoShouldSend(Time now, uint32_t nFixes, uint32_t batchSize, uint32_t packetSize) const;
+
+  double m_angle;
+  double m_minDistance;
+  bool m_hasAnchor;
+  PositionSample m_anchor;  // where the current leg started
+  bool m_hasHeading;
+  double m_heading;         // of the latest leg, in radians
+  bool m_hasReference;
+  double m_reference;       // heading at the last send, in radians
+  double m_turn;            // largest turn from m_reference since then
+};
+
+/**
+ * \param name one of count, fresh, age, bytes, distance and heading
+ * \return a new policy of that kind, configured from the attribute
+ * defaults, or 0 if there is no such policy
+ */
+Ptr<BatchPolicy> CreateBatchPolicy(const std::string &name);
+
+} // namespace ns3
+
+#endif /* BATCH_POLICY_H */
@@ -0,0 +1,188 @@
+#ifndef BUFFERED_POSITION_CLIENT_H
+#define BUFFERED_POSITION_CLIENT_H
+
+#include "position-client.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * A client that sends each fix once and never hears back. With
+ * StoreAndForward it holds fixes while out of coverage and sends them on
+ * re-entry, instead of sending batches that are lost.
+ */
+template <typename Client, typename Codec>
+class BufferedPositionClient : public PositionClient<Client, Codec> {
+public:
+  /**
+   * Adds the attributes of PositionClient and of store-and-forward to tid.
+   */
+  static TypeId AddAttributes(TypeId tid);
+
+  explicit BufferedPositionClient(const std::string &logComponent);
+
+protected:
+  typedef PositionClient<Client, Codec> Base;
+  friend class PositionClient<Client, Codec>;
+
+  void Keep(const PositionSample &sample);
+  void Send(void);
+  bool TracksCoverage(void) const { return m_storeAndForward; }
+  void OnCoverageChanged(bool inside);
+  void OnStop(void);
+  void OnLost(uint32_t count) const;
+
+  /**
+   * Sends the fixes gathered if the batch policy says so, or regardless
+   * with force.
+   * \return false if the node is out of coverage and holds the fixes until
+   * it is back
+   */
+  bool SendPending(bool force);
+  void Flush(void);
+
+  using Base::g_log;
+
+  std::vector<PositionSample> m_positions;
+  bool m_storeAndForward;
+  uint32_t m_maxStoredPositions;
+  uint32_t m_maxPositionsPerPacket;
+  bool m_suspended;
+};
+
+template <typename Client, typename Codec>
+TypeId BufferedPositionClient<Client, Codec>::AddAttributes(TypeId tid) {
+  return Base::AddAttributes(tid)
+    .AddAttribute("StoreAndForward", 
+                   "Hold positions while out of coverage and send them on re-entry instead of dropping batches",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&BufferedPositionClient::m_storeAndForward),
+                   MakeBooleanChecker())
+    .AddAttribute("MaxStoredPositions", 
+                   "Positions held at most while out of coverage; the oldest are dropped beyond it",
+                   UintegerValue(600),
+                   MakeUintegerAccessor(&BufferedPositionClient::m_maxStoredPositions),
+                   MakeUintegerChecker<uint32_t>(1))
+    .AddAttribute("MaxPositionsPerPacket", 
+                   "Positions sent at most in each packet when held positions are flushed; the default keeps a text batch within a 1500-byte MTU",
+                   UintegerValue(32),
+                   MakeUintegerAccessor(&BufferedPositionClient::m_maxPositionsPerPacket),
+                   MakeUintegerChecker<uint32_t>(1))
+  ;
+}
+
+template <typename Client, typename Codec>
+BufferedPositionClient<Client, Codec>::BufferedPositionClient(const std::string &logComponent)
+  : Base(logComponent) {
+  NS_LOG_FUNCTION(this);
+  m_storeAndForward = false;
+  m_maxStoredPositions = 600;
+  m_maxPositionsPerPacket = 32;
+  m_suspended = false;
+}
+
+template <typename Client, typename Codec>
+void  BufferedPositionClient<Client, Codec>::Keep(const PositionSample &sample) {
+  m_positions.push_back(sample);
+
+  // Only held positions pile up; when they overflow, the oldest packet of
+  // the flush they were waiting for goes.
+  if (m_storeAndForward && m_positions.size() > m_maxStoredPositions) {
+    uint32_t dropped = std::min<uint32_t>(m_maxPositionsPerPacket, m_positions.size());
+    m_positions.erase(m_positions.begin(), m_positions.begin() + dropped);
+    NS_LOG_INFO("Package lost with " << dropped << " positions");
+    // Counted as a batch sent and lost, as when one goes out of coverage.
+    ++this->m_lost;
+    ++this->m_sent;
+  }
+}
+
+template <typename Client, typename Codec>
+void  BufferedPositionClient<Client, Codec>::Send(void) {
+  NS_LOG_FUNCTION(this);
+
+  NS_ASSERT(this->m_sendEvent.IsExpired());
+
+  if (SendPending(false)) {
+    this->ScheduleTransmit(this->m_interval);
+  }
+}
+
+template <typename Client, typename Codec>
+bool  BufferedPositionClient<Client, Codec>::SendPending(bool force) {
+  NS_LOG_FUNCTION(this << force);
+
+  Vector enbPos;
+  bool covered = this->IsCovered(enbPos);
+
+  // The tracker decides, so that the node is held exactly until the
+  // crossing it will report in CoverageChanged.
+  if (m_storeAndForward && !this->m_coverage.IsInside()) {
+    NS_LOG_INFO("Holding " << m_positions.size() << " positions out of coverage");
+    m_suspended = true;
+    return false;
+  }
+
+  if (m_positions.empty()) {
+    return true;
+  }
+
+  auto encode = [this, &enbPos]() {
+    this->EncodeBatch(m_positions.data(), m_positions.size(), enbPos);
+  };
+  if (force) {
+    encode();
+  } else if (!this->EncodeIfDue(m_positions.size(), encode)) {
+    return true;
+  }
+
+  this->TransmitBatch(m_positions.data(), m_positions.size(), enbPos, covered);
+  m_positions.clear();
+  this->m_batchPolicy->Clear();
+  return true;
+}
+
+template <typename Client, typename Codec>
+void  BufferedPositionClient<Client, Codec>::OnCoverageChanged(bool inside) {
+  if (inside && m_suspended) {
+    m_suspended = false;
+    Flush();
+    if (this->Self().SendsOnTimer()) {
+      this->ScheduleTransmit(this->m_interval);
+    }
+  }
+}
+
+template <typename Client, typename Codec>
+void  BufferedPositionClient<Client, Codec>::OnStop(void) {
+  m_positions.clear();
+  m_suspended = false;
+}
+
+template <typename Client, typename Codec>
+void  BufferedPositionClient<Client, Codec>::OnLost(uint32_t count) const {
+  NS_LOG_INFO("Package lost with " << count << " positions");
+}
+
+template <typename Client, typename Codec>
+void  BufferedPositionClient<Client, Codec>::Flush(void) {
+  NS_LOG_FUNCTION(this);
+
+  Vector enbPos = this->m_enbNode->template GetObject<MobilityModel>()->GetPosition();
+
+  // Oldest positions first, so the newest is the last the server hears of.
+  for (uint32_t first = 0; first < m_positions.size(); first += m_maxPositionsPerPacket) {
+    uint32_t count = std::min<uint32_t>(m_positions.size() - first, m_maxPositionsPerPacket);
+    this->EncodeBatch(&m_positions[first], count, enbPos);
+    this->TransmitBatch(&m_positions[first], count, enbPos, true);
+  }
+  m_positions.clear();
+  this->m_batchPolicy->Clear();
+}
+
+} // namespace ns3
+
+#endif /* BUFFERED_POSITION_CLIENT_H */
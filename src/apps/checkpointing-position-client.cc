@@ -1,22 +1,22 @@
 #include "ns3/log.h"
-#include "ns3/pointer.h"
+#include "ns3/boolean.h"
 #include "ns3/double.h"
-#include "ns3/ipv4-address.h"
-#include "ns3/ipv6-address.h"
-#include "ns3/nstime.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/inet6-socket-address.h"
-#include "ns3/socket.h"
-#include "ns3/simulator.h"
-#include "ns3/socket-factory.h"
+#include "ns3/mobility-module.h"
+#include "ns3/nstime.h"
 #include "ns3/packet.h"
-#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
 #include "ns3/trace-source-accessor.h"
-#include "ns3/mobility-module.h"
+#include "ns3/uinteger.h"
 #include "checkpointing-position-client.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <sstream>
-#include <iostream>
+#include <string>
 
 namespace ns3 {
 
@@ -25,270 +25,249 @@ NS_LOG_COMPONENT_DEFINE("CheckpointingPositionClientApplication");
 NS_OBJECT_ENSURE_REGISTERED(CheckpointingPositionClient);
 
 TypeId CheckpointingPositionClient::GetTypeId(void) {
-  static TypeId tid = TypeId("ns3::CheckpointingPositionClient")
+  static TypeId tid = AddAttributes(TypeId("ns3::CheckpointingPositionClient")
     .SetParent<Application>()
     .SetGroupName("Applications")
-    .AddConstructor<CheckpointingPositionClient>()
-    .AddAttribute("Interval", 
-                   "The time to wait between packets",
+    .AddConstructor<CheckpointingPositionClient>())
+    .AddAttribute("AdaptiveInterval", 
+                   "Lengthen the time between packets when acks come late or not at all and shorten it while they come on time",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&CheckpointingPositionClient::m_adaptiveInterval),
+                   MakeBooleanChecker())
+    .AddAttribute("MinInterval", 
+                   "Shortest time between packets with AdaptiveInterval",
                    TimeValue(Seconds(1.0)),
-                   MakeTimeAccessor(&CheckpointingPositionClient::m_interval),
+                   MakeTimeAccessor(&CheckpointingPositionClient::m_minInterval),
                    MakeTimeChecker())
-    .AddAttribute("PositionInterval", 
-                   "The time to wait between gathering position",
-                   TimeValue(Seconds(1.0)),
-                   MakeTimeAccessor(&CheckpointingPositionClient::m_positionInterval),
+    .AddAttribute("MaxInterval", 
+                   "Longest time between packets with AdaptiveInterval",
+                   TimeValue(Seconds(600.0)),
+                   MakeTimeAccessor(&CheckpointingPositionClient::m_maxInterval),
+                   MakeTimeChecker())
+    .AddAttribute("IntervalStep", 
+                   "How much each timely ack shortens the time between packets",
+                   TimeValue(Seconds(5.0)),
+                   MakeTimeAccessor(&CheckpointingPositionClient::m_intervalStep),
                    MakeTimeChecker())
-    .AddAttribute("Node", 
-                   "The node in which the application is installed",
-                   PointerValue(nullptr),
-                   MakePointerAccessor(&CheckpointingPositionClient::m_node),
-                   MakePointerChecker<Node>())
-    .AddAttribute("ExtraPayloadSize", 
-                   "Extra payload size to add to packets",
+    .AddAttribute("IntervalBackoff", 
+                   "Factor a late or missing ack lengthens the time between packets by",
+                   DoubleValue(2.0),
+                   MakeDoubleAccessor(&CheckpointingPositionClient::m_intervalBackoff),
+                   MakeDoubleChecker<double>(1.0))
+    .AddAttribute("LateAckFactor", 
+                   "An ack is late when its round trip exceeds the shortest one seen by this factor",
+                   DoubleValue(2.0),
+                   MakeDoubleAccessor(&CheckpointingPositionClient::m_lateAckFactor),
+                   MakeDoubleChecker<double>(1.0))
+    .AddAttribute("MaxBacklog", 
+                   "Most unacknowledged positions kept, evicting those that least change the route's shape (0 keeps them all)",
                    UintegerValue(0),
-                   MakeUintegerAccessor(&CheckpointingPositionClient::m_extraPayloadSize),
+                   MakeUintegerAccessor(&CheckpointingPositionClient::m_maxBacklog),
                    MakeUintegerChecker<uint32_t>())
-    .AddAttribute("AmountPositionsToSend", 
-                   "Amount of positions to send each time",
-                   UintegerValue(10),
-                   MakeUintegerAccessor(&CheckpointingPositionClient::m_amountPositionsToSend),
+    .AddAttribute("MaxBacklogBytes", 
+                   "Most bytes the unacknowledged positions may take as text, evicting as for MaxBacklog (0 for no bound)",
+                   UintegerValue(0),
+                   MakeUintegerAccessor(&CheckpointingPositionClient::m_maxBacklogBytes),
                    MakeUintegerChecker<uint32_t>())
-    .AddAttribute("EnbNode", 
-                   "The enbNode to which the node is attached to",
-                   PointerValue(nullptr),
-                   MakePointerAccessor(&CheckpointingPositionClient::m_enbNode),
-                   MakePointerChecker<Node>())
-    .AddAttribute("Range", 
-                   "The enbNode range",
+    .AddAttribute("BacklogTolerance", 
+                   "Meters a position may stray from the line through its neighbours and still be evicted within the bounds (0 only evicts past them)",
                    DoubleValue(0.0),
-                   MakeDoubleAccessor(&CheckpointingPositionClient::m_range),
-                   MakeDoubleChecker<double>())
-    .AddAttribute("RemoteAddress", 
-                   "The destination Address of the outbound packets",
-                   AddressValue(),
-                   MakeAddressAccessor(&CheckpointingPositionClient::m_peerAddress),
-                   MakeAddressChecker())
-    .AddAttribute("RemotePort", 
-                   "The destination port of the outbound packets",
-                   UintegerValue(0),
-                   MakeUintegerAccessor(&CheckpointingPositionClient::m_peerPort),
-                   MakeUintegerChecker<uint16_t>())
-    .AddTraceSource("Tx", "A new packet is created and is sent",
-                     MakeTraceSourceAccessor(&CheckpointingPositionClient::m_txTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource("Rx", "A packet has been received",
-                     MakeTraceSourceAccessor(&CheckpointingPositionClient::m_rxTrace),
-                     "ns3::Packet::TracedCallback")
-    .AddTraceSource("TxWithAddresses", "A new packet is created and is sent",
-                     MakeTraceSourceAccessor(&CheckpointingPositionClient::m_txTraceWithAddresses),
-                     "ns3::Packet::TwoAddressTracedCallback")
-    .AddTraceSource("RxWithAddresses", "A packet has been received",
-                     MakeTraceSourceAccessor(&CheckpointingPositionClient::m_rxTraceWithAddresses),
-                     "ns3::Packet::TwoAddressTracedCallback")
+                   MakeDoubleAccessor(&CheckpointingPositionClient::m_backlogTolerance),
+                   MakeDoubleChecker<double>(0.0))
+    .AddAttribute("Windowed", 
+                   "Send each position once and resend it only on timeout or when the server skips it, instead of resending every unacknowledged position",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&CheckpointingPositionClient::m_windowed),
+                   MakeBooleanChecker())
+    .AddAttribute("MinWindow", 
+                   "Fewest positions allowed in flight in windowed mode",
+                   UintegerValue(20),
+                   MakeUintegerAccessor(&CheckpointingPositionClient::m_minWindow),
+                   MakeUintegerChecker<uint32_t>(1))
+    .AddAttribute("MinRto", 
+                   "Lower bound of the retransmission timeout in windowed mode",
+                   TimeValue(Seconds(1.0)),
+                   MakeTimeAccessor(&CheckpointingPositionClient::m_minRto),
+                   MakeTimeChecker())
+    .AddAttribute("MaxRto", 
+                   "Upper bound of the retransmission timeout in windowed mode",
+                   TimeValue(Seconds(60.0)),
+                   MakeTimeAccessor(&CheckpointingPositionClient::m_maxRto),
+                   MakeTimeChecker())
+    .AddTraceSource("SendInterval", "The time between packets, as AdaptiveInterval changes it",
+                     MakeTraceSourceAccessor(&CheckpointingPositionClient::m_sendInterval),
+                     "ns3::TracedValueCallback::Time")
   ;
   return tid;
 }
 
-CheckpointingPositionClient::CheckpointingPositionClient() {
+CheckpointingPositionClient::CheckpointingPositionClient()
+  : PositionClient("CheckpointingPositionClientApplication") {
   NS_LOG_FUNCTION(this);
-  m_sent = 0;
-  m_lost = 0;
-  m_socket = 0;
-  m_node = nullptr;
-  m_enbNode = nullptr;
-  m_nextId = 0;
-  m_extraPayloadSize = 0;
-  m_sendEvent = EventId();
+  m_adaptiveInterval = false;
+  m_minInterval = Seconds(1.0);
+  m_maxInterval = Seconds(600.0);
+  m_intervalStep = Seconds(5.0);
+  m_intervalBackoff = 2.0;
+  m_lateAckFactor = 2.0;
+  m_maxBacklog = 0;
+  m_maxBacklogBytes = 0;
+  m_backlogTolerance = 0;
+  m_windowed = false;
+  m_minWindow = 20;
+  m_minRto = Seconds(1.0);
+  m_maxRto = Seconds(60.0);
+  m_backoff = 1;
 }
 
 CheckpointingPositionClient::~CheckpointingPositionClient() {
   NS_LOG_FUNCTION(this);
-  m_socket = 0;
-  m_node = nullptr;
-  m_enbNode = nullptr;
 }
 
 void CheckpointingPositionClient::DoDispose(void) {
   NS_LOG_FUNCTION(this);
-  Application::DoDispose();
+  m_rtt = 0;
+  PositionClient::DoDispose();
 }
 
-void  CheckpointingPositionClient::StartApplication(void) {
-  NS_LOG_FUNCTION(this);
-
-  if (m_socket == 0) {
-    TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
-    m_socket = Socket::CreateSocket(GetNode(), tid);
-    if (Ipv4Address::IsMatchingType(m_peerAddress) == true) {
-      if (m_socket->Bind() == -1) {
-        NS_FATAL_ERROR("Failed to bind socket");
-      }
-
-      m_socket->Connect(InetSocketAddress(Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
-    } else if (Ipv6Address::IsMatchingType(m_peerAddress) == true) {
-      if (m_socket->Bind6() == -1) {
-        NS_FATAL_ERROR("Failed to bind socket");
-      }
-
-      m_socket->Connect(Inet6SocketAddress(Ipv6Address::ConvertFrom(m_peerAddress), m_peerPort));
-    } else if (InetSocketAddress::IsMatchingType(m_peerAddress) == true) {
-      if (m_socket->Bind() == -1) {
-        NS_FATAL_ERROR("Failed to bind socket");
-      }
-
-      m_socket->Connect(m_peerAddress);
-    } else if (Inet6SocketAddress::IsMatchingType(m_peerAddress) == true) {
-      if (m_socket->Bind6() == -1) {
-        NS_FATAL_ERROR("Failed to bind socket");
-      }
-
-      m_socket->Connect(m_peerAddress);
-    } else {
-      NS_ASSERT_MSG(false, "Incompatible address type: " << m_peerAddress);
-    }
+void  CheckpointingPositionClient::OnStart(void) {
+  m_positions.SetLimits(m_maxBacklog, m_maxBacklogBytes, m_backlogTolerance);
+  if (m_windowed || m_adaptiveInterval) {
+    m_rtt = CreateObject<RttMeanDeviation>();
+    m_backoff = 1;
   }
+  m_sendInterval = m_interval;
+  m_minRtt = Time::Max();
+  m_nextSlowdown = Seconds(0.0);
+  m_probes.clear();
 
   m_socket->SetRecvCallback(MakeCallback(&CheckpointingPositionClient::HandleRead, this));
-  m_socket->SetAllowBroadcast(false);
-  ScheduleTransmit(Seconds(0.));
-  SchedulePositionGathering(Seconds(0.));
-  ScheduleInside(Seconds(0.));
 }
 
-void  CheckpointingPositionClient::StopApplication() {
-  NS_LOG_FUNCTION(this);
-
-  if (m_socket != 0)  {
-    m_socket->Close();
-    m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
-    m_socket = 0;
+void  CheckpointingPositionClient::OnStop(void) {
+  m_positions.Clear();
+  if (m_positions.GetNEvicted() > 0) {
+    NS_LOG_INFO("evicted " << m_positions.GetNEvicted() << " fixes from the backlog, straying up to "
+                << m_positions.GetMaxEvictedError() << "m");
   }
-
-  Simulator::Cancel(m_sendEvent);
-  m_positionMap.clear();
-}
-
-void  CheckpointingPositionClient::ScheduleInside(Time dt) {
-  NS_LOG_FUNCTION(this << dt);
-  Simulator::Schedule(dt, &CheckpointingPositionClient::Inside, this);
 }
 
-void  CheckpointingPositionClient::ScheduleTransmit(Time dt) {
-  NS_LOG_FUNCTION(this << dt);
-  m_sendEvent = Simulator::Schedule(dt, &CheckpointingPositionClient::Send, this);
+void  CheckpointingPositionClient::Keep(const PositionSample &sample) {
+  m_positions.Push(sample);
 }
 
-void  CheckpointingPositionClient::SchedulePositionGathering(Time dt) {
-  NS_LOG_FUNCTION(this << dt);
-  Simulator::Schedule(dt, &CheckpointingPositionClient::GatherPosition, this);
-}
-
-void  CheckpointingPositionClient::Inside(void) {
+void  CheckpointingPositionClient::Send(void) {
   NS_LOG_FUNCTION(this);
 
-  Ptr<MobilityModel> ueMobility = m_node->GetObject<MobilityModel>();
-  Ptr<MobilityModel> enbMobility = m_enbNode->GetObject<MobilityModel>();
+  NS_ASSERT(m_sendEvent.IsExpired());
 
-  Vector uePos = ueMobility->GetPosition();
-  Vector enbPos = enbMobility->GetPosition();
-  double distance = CalculateDistance(uePos, enbPos);
+  Vector enbPos;
+  bool covered = IsCovered(enbPos);
 
-  if (m_range <= distance) {
-    NS_LOG_INFO("inside");
-  } else {
-    NS_LOG_INFO("outside");
+  if (m_adaptiveInterval) {
+    ExpireProbes();
   }
 
-  Simulator::Schedule(Seconds(1.0), &CheckpointingPositionClient::Inside, this);
-}
-
-void  CheckpointingPositionClient::GatherPosition(void) {
-  NS_LOG_FUNCTION(this);
-
-  Ptr<MobilityModel> ueMobility = m_node->GetObject<MobilityModel>();
-  Vector uePos = ueMobility->GetPosition();
+  if (m_windowed) {
+    SendWindow(covered);
+    ScheduleTransmit(m_sendInterval);
+    return;
+  }
 
-  std::ostringstream pos;
-  pos << uePos.x << "," << uePos.y << "," << uePos.z;
-  std::string msg = pos.str();
+  if (m_positions.GetNPending() == 0) {
+    ScheduleTransmit(m_sendInterval);
+    return;
+  }
 
-  m_positionMap[m_nextId++] = msg;
-  NS_LOG_INFO("consumed 33 mJ");
+  // The packet carries every fix still waiting for an ack, so that is
+  // what the policy counts, as AmountPositionsToSend always did.
+  bool due = EncodeIfDue(m_positions.GetNPending(), [this, &enbPos]() {
+    m_batch.clear();
+    m_positions.VisitNewestFirst([this](const PositionSample &sample) {
+      m_batch.push_back(sample);
+    });
+    std::reverse(m_batch.begin(), m_batch.end());
+    EncodeBatch(m_batch.data(), m_batch.size(), enbPos);
+  });
+  if (!due) {
+    ScheduleTransmit(m_sendInterval);
+    return;
+  }
+  m_batchPolicy->Clear();
 
-  Simulator::Schedule(m_positionInterval, &CheckpointingPositionClient::GatherPosition, this);
+  SendBatch(enbPos, covered);
+  ScheduleTransmit(m_sendInterval);
 }
 
-void  CheckpointingPositionClient::Send(void) {
-  NS_LOG_FUNCTION(this);
+void  CheckpointingPositionClient::SendWindow(bool covered) {
+  NS_LOG_FUNCTION(this << covered);
 
-  NS_ASSERT(m_sendEvent.IsExpired());
-
-  Ptr<MobilityModel> ueMobility = m_node->GetObject<MobilityModel>();
-  Ptr<MobilityModel> enbMobility = m_enbNode->GetObject<MobilityModel>();
-
-  Vector uePos = ueMobility->GetPosition();
-  Vector enbPos = enbMobility->GetPosition();
-  double distance = CalculateDistance(uePos, enbPos);
-
-  NS_LOG_INFO("is " << distance << "m from eNB");
-
-  if (m_positionMap.size() < m_amountPositionsToSend) {
-    ScheduleTransmit(m_interval);
+  int64_t now = Simulator::Now().GetTimeStep();
+  uint32_t window = GetWindow();
+  PositionBacklog::Selection selection = m_positions.SelectDue(now, GetRto().GetTimeStep(), window);
+  if (selection.count == 0) {
     return;
   }
 
-  Address localAddress;
-  m_socket->GetSockName(localAddress);
-
-  std::ostringstream pos;
-  for (auto posPair = m_positionMap.rbegin(); posPair != m_positionMap.rend(); ++posPair) {
-    pos << posPair->first << " " << posPair->second << "\n";
+  Vector enbPos = m_enbNode->GetObject<MobilityModel>()->GetPosition();
+  auto encode = [this, &enbPos]() {
+    m_batch.clear();
+    m_positions.VisitSelectedNewestFirst([this](const PositionSample &sample) {
+      m_batch.push_back(sample);
+    });
+    std::reverse(m_batch.begin(), m_batch.end());
+    EncodeBatch(m_batch.data(), m_batch.size(), enbPos);
+  };
+
+  // New fixes still wait for the policy; fixes already overdue do not.
+  if (selection.retransmissions > 0) {
+    encode();
+  } else if (!EncodeIfDue(selection.count, encode)) {
+    return;
+  }
+  // Fixes held back by the window keep the policy armed, so they follow
+  // as soon as acks make room.
+  if (selection.leftOut == 0) {
+    m_batchPolicy->Clear();
+  }
+  if (selection.timedOut > 0) {
+    m_backoff = std::min(m_backoff * 2, 64u);
   }
 
-  pos << std::string(m_extraPayloadSize, '.');
-  std::string msg = pos.str();
-
-  Ptr<Packet> p = Create<Packet>(
-      reinterpret_cast<const uint8_t*>(msg.c_str()), 
-      msg.size()
-  );
+  NS_LOG_INFO("sending " << selection.count << " positions, " << selection.retransmissions << " resent, "
+              << selection.leftOut << " over the window of " << window);
+  m_positions.MarkSelectedSent(now);
+  SendBatch(enbPos, covered);
+}
 
-  m_txTrace(p);
+void  CheckpointingPositionClient::SendBatch(const Vector &enbPos, bool covered) {
+  NS_LOG_FUNCTION(this << covered);
 
-  if (Ipv4Address::IsMatchingType(m_peerAddress)) {
-    m_txTraceWithAddresses(p, localAddress, InetSocketAddress(Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
-  } else if (Ipv6Address::IsMatchingType(m_peerAddress)) {
-    m_txTraceWithAddresses(p, localAddress, Inet6SocketAddress(Ipv6Address::ConvertFrom(m_peerAddress), m_peerPort));
+  // Like a real client, this one cannot tell a packet lost out of
+  // coverage, so it is timed all the same.
+  if (m_adaptiveInterval) {
+    AddProbe(m_batch.back().id);
   }
+  TransmitBatch(m_batch.data(), m_batch.size(), enbPos, covered);
+}
 
-  if (m_range > distance) {
-    NS_LOG_INFO("Package lost");
-    ++m_lost;
-    ++m_sent;
-
-    ScheduleTransmit(m_interval);
-    return;
-  }
+Time  CheckpointingPositionClient::GetRto(void) const {
+  // RFC 6298: smoothed RTT plus four deviations, backed off exponentially
+  // while acks stay away.
+  Time rto = m_rtt->GetEstimate() + m_rtt->GetVariation() * 4;
+  rto = std::min(std::max(rto, m_minRto), m_maxRto);
+  return std::min(rto * m_backoff, m_maxRto);
+}
 
-  m_socket->Send(p);
-  ++m_sent;
-
-  if (Ipv4Address::IsMatchingType(m_peerAddress)) {
-    NS_LOG_INFO("sent '" << msg << "' to " << Ipv4Address::ConvertFrom(m_peerAddress)
-                << " port " << m_peerPort);
-  } else if (Ipv6Address::IsMatchingType(m_peerAddress)) {
-    NS_LOG_INFO("sent '" << msg << "' to " << Ipv6Address::ConvertFrom(m_peerAddress)
-                << " port " << m_peerPort);
-  } else if (InetSocketAddress::IsMatchingType(m_peerAddress)) {
-    NS_LOG_INFO("sent '" << msg << "' to " << InetSocketAddress::ConvertFrom(m_peerAddress).GetIpv4()
-                << " port " << InetSocketAddress::ConvertFrom(m_peerAddress).GetPort());
-  } else if (Inet6SocketAddress::IsMatchingType(m_peerAddress)) {
-    NS_LOG_INFO("sent '" << msg << "' to " << Inet6SocketAddress::ConvertFrom(m_peerAddress).GetIpv6()
-                << " port " << Inet6SocketAddress::ConvertFrom(m_peerAddress).GetPort());
+uint32_t  CheckpointingPositionClient::GetWindow(void) const {
+  // Fixes taken while one goes out and its ack can still come back; twice
+  // that leaves room for resending the ones the server skipped.
+  double perFix = m_positionInterval.GetSeconds();
+  if (m_sampler != 0 || perFix <= 0) {
+    return m_minWindow;
   }
-
-  ScheduleTransmit(m_interval);
+  double inFlight = std::ceil((m_sendInterval.Get() + GetRto()).GetSeconds() / perFix);
+  return std::max(m_minWindow, static_cast<uint32_t>(2 * inFlight));
 }
 
 void CheckpointingPositionClient::HandleRead(Ptr<Socket> socket) {
@@ -322,21 +301,127 @@ void CheckpointingPositionClient::HandleRead(Ptr<Socket> socket) {
 
     std::istringstream batch(msg);
     std::string line;
+    int64_t sentAt = 0;
+    bool timed = false;
+    uint32_t newestId = 0;
+    bool acked = false;
 
+    // The server acknowledges runs of ids as "<first>-<last> OK" and lone
+    // ids as "<id> OK".
     while (std::getline(batch, line)) {
-      size_t idSep = line.find(" ");
-
-      if (idSep != std::string::npos) {
-        std::string posIdRaw = line.substr(0, idSep);
-        uint32_t posId = std::stoul(posIdRaw);
-        m_positionMap.erase(posId);
-
-        NS_LOG_INFO("received OK for ID " << posId);
+      uint32_t firstId, lastId;
+      if (std::sscanf(line.c_str(), "%u-%u OK", &firstId, &lastId) == 2) {
+        timed |= Acknowledge(firstId, lastId, sentAt);
+        NS_LOG_INFO("received OK for IDs " << firstId << " to " << lastId);
+      } else if (std::sscanf(line.c_str(), "%u OK", &firstId) == 1) {
+        lastId = firstId;
+        timed |= Acknowledge(firstId, lastId, sentAt);
+        NS_LOG_INFO("received OK for ID " << firstId);
+      } else {
+        continue;
       }
+      if (!acked || static_cast<int32_t>(lastId - newestId) > 0) {
+        newestId = lastId;
+        acked = true;
+      }
+    }
+    if (timed) {
+      AckTimed(sentAt);
+    }
+    if (acked && m_adaptiveInterval) {
+      AckProbes(newestId);
     }
 
     delete[] msgRaw;
   }
 }
 
+bool CheckpointingPositionClient::Acknowledge(uint32_t firstId, uint32_t lastId, int64_t &sentAt) {
+  // Only a fix sent once times the round trip unambiguously (Karn).
+  int64_t rangeSentAt;
+  bool timed = m_windowed && m_positions.GetSingleTransmission(lastId, rangeSentAt);
+  m_positions.AckRange(firstId, lastId);
+  if (timed) {
+    sentAt = std::max(sentAt, rangeSentAt);
+  }
+  return timed;
+}
+
+void CheckpointingPositionClient::AckTimed(int64_t sentAt) {
+  m_rtt->Measurement(Simulator::Now() - TimeStep(sentAt));
+  m_backoff = 1;
+
+  // The uplink delivers in order, so fixes from an earlier packet that are
+  // still unacknowledged were skipped: they are resent right away instead
+  // of waiting for their timeout.
+  m_positions.MarkLostBefore(sentAt);
+}
+
+void CheckpointingPositionClient::AddProbe(uint32_t newestId) {
+  // Only a packet with a fix newer than any sent before can be told apart
+  // by its ack.
+  if (!m_probes.empty() && static_cast<int32_t>(newestId - m_probes.back().newestId) <= 0) {
+    return;
+  }
+  Probe probe = {Simulator::Now(), newestId};
+  m_probes.push_back(probe);
+}
+
+void CheckpointingPositionClient::AckProbes(uint32_t newestId) {
+  // Acks come back in order, so probes older than the acknowledged one
+  // went unanswered.
+  bool lost = false;
+  while (!m_probes.empty() && static_cast<int32_t>(m_probes.front().newestId - newestId) < 0) {
+    m_probes.pop_front();
+    lost = true;
+  }
+  if (m_probes.empty() || m_probes.front().newestId != newestId) {
+    if (lost) {
+      AdaptInterval(true);
+    }
+    return;
+  }
+
+  Time rtt = Simulator::Now() - m_probes.front().sentAt;
+  m_probes.pop_front();
+  // The windowed mode times the round trip per fix already.
+  if (!m_windowed) {
+    m_rtt->Measurement(rtt);
+  }
+  m_minRtt = std::min(m_minRtt, rtt);
+  bool late = rtt.GetSeconds() > m_minRtt.GetSeconds() * m_lateAckFactor;
+  NS_LOG_LOGIC("ack after " << rtt.GetSeconds() << "s" << (late ? ", late" : ""));
+  AdaptInterval(lost || late);
+}
+
+void CheckpointingPositionClient::ExpireProbes(void) {
+  Time timeout = GetRto();
+  bool lost = false;
+  while (!m_probes.empty() && Simulator::Now() - m_probes.front().sentAt >= timeout) {
+    m_probes.pop_front();
+    lost = true;
+  }
+  if (lost) {
+    AdaptInterval(true);
+  }
+}
+
+void CheckpointingPositionClient::AdaptInterval(bool congested) {
+  Time interval = m_sendInterval;
+  if (congested) {
+    // At most once per round trip, so a burst of losses slows down once.
+    if (Simulator::Now() < m_nextSlowdown) {
+      return;
+    }
+    m_nextSlowdown = Simulator::Now() + m_rtt->GetEstimate();
+    interval = Seconds(interval.GetSeconds() * m_intervalBackoff);
+  } else {
+    interval -= m_intervalStep;
+  }
+  m_sendInterval = std::min(std::max(interval, m_minInterval), m_maxInterval);
+  if (congested) {
+    NS_LOG_INFO("slowing down to one packet every " << m_sendInterval.Get().GetSeconds() << "s");
+  }
+}
+
 } // Namespace ns3
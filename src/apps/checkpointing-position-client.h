@@ -1,19 +1,21 @@
 #ifndef CHECKPOINTING_POSITION_CLIENT_H
 #define CHECKPOINTING_POSITION_CLIENT_H
 
-#include "ns3/application.h"
-#include "ns3/event-id.h"
-#include "ns3/ptr.h"
-#include "ns3/ipv4-address.h"
-#include "ns3/traced-callback.h"
-#include "ns3/random-variable-stream.h"
+#include "ns3/traced-value.h"
+#include "ns3/rtt-estimator.h"
+#include "position-backlog.h"
+#include "position-client.h"
 
-namespace ns3 {
+#include <deque>
+#include <vector>
 
-class Socket;
-class Packet;
+namespace ns3 {
 
-class CheckpointingPositionClient : public Application {
+/**
+ * Keeps every fix until the server acknowledges it and sends it again
+ * until then.
+ */
+class CheckpointingPositionClient : public PositionClient<CheckpointingPositionClient, PositionCodec> {
 public:
   static TypeId GetTypeId(void);
   CheckpointingPositionClient();
@@ -23,42 +25,86 @@ protected:
   virtual void DoDispose(void);
 
 private:
-  virtual void StartApplication(void);
-  virtual void StopApplication(void);
+  friend class PositionClient<CheckpointingPositionClient, PositionCodec>;
 
-  void ScheduleInside(Time dt);
-  void ScheduleTransmit(Time dt);
-  void SchedulePositionGathering(Time dt);
-  void Inside(void);
-  void GatherPosition(void);
+  void OnStart(void);
+  void OnStop(void);
+  void Keep(const PositionSample &sample);
   void Send(void);
+  /**
+   * Windowed mode: sends the fixes never sent and those whose
+   * retransmission timeout expired or that the server skipped.
+   */
+  void SendWindow(bool covered);
+  /**
+   * Sends m_batch, already encoded in m_payload.
+   */
+  void SendBatch(const Vector &enbPos, bool covered);
+  Time GetRto(void) const;
+  /**
+   * \return how many fixes may be in flight
+   */
+  uint32_t GetWindow(void) const;
 
   void HandleRead(Ptr<Socket> socket);
+  /**
+   * Acknowledges a range of ids. In windowed mode, when the range's newest
+   * fix was sent once, raises sentAt to when it was sent.
+   * \return whether the range timed a round trip
+   */
+  bool Acknowledge(uint32_t firstId, uint32_t lastId, int64_t &sentAt);
+  /**
+   * Windowed mode: takes the round trip of the packet sent at sentAt and
+   * marks what was sent before it and never acknowledged as lost.
+   */
+  void AckTimed(int64_t sentAt);
+  /**
+   * AdaptiveInterval: times the packet whose newest fix is newestId.
+   */
+  void AddProbe(uint32_t newestId);
+  /**
+   * AdaptiveInterval: takes an ack whose newest fix is newestId.
+   */
+  void AckProbes(uint32_t newestId);
+  /**
+   * AdaptiveInterval: gives up on packets unanswered for an RTO.
+   */
+  void ExpireProbes(void);
+  /**
+   * Multiplies the interval by IntervalBackoff when the channel is
+   * congested, or shortens it by IntervalStep when it is not.
+   */
+  void AdaptInterval(bool congested);
 
-  Ptr<Node> m_node;
-  Ptr<Node> m_enbNode;
-  std::map<uint32_t, std::string> m_positionMap;
-  uint32_t m_nextId;
-  double m_range;
-
-  Time m_interval;
-  Time m_positionInterval;
-  uint32_t m_extraPayloadSize;
-  uint32_t m_amountPositionsToSend;
+  PositionBacklog m_positions;
+  std::vector<PositionSample> m_batch;  // fixes being sent, oldest first
 
-  uint32_t m_sent;
-  uint32_t m_lost;
-  Ptr<Socket> m_socket;
-  Address m_peerAddress;
-  uint16_t m_peerPort;
-  EventId m_sendEvent;
+  bool m_adaptiveInterval;
+  Time m_minInterval;
+  Time m_maxInterval;
+  Time m_intervalStep;
+  double m_intervalBackoff;
+  double m_lateAckFactor;
+  TracedValue<Time> m_sendInterval;  // Interval, or what AdaptiveInterval made of it
+  uint32_t m_maxBacklog;
+  uint32_t m_maxBacklogBytes;
+  double m_backlogTolerance;
+  bool m_windowed;
+  uint32_t m_minWindow;
+  Time m_minRto;
+  Time m_maxRto;
+  Ptr<RttEstimator> m_rtt;
+  uint32_t m_backoff;  // RTO multiplier, doubled on every timeout
 
-  TracedCallback<Ptr<const Packet>> m_txTrace;
-  TracedCallback<Ptr<const Packet>> m_rxTrace;
-  TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_txTraceWithAddresses;
-  TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_rxTraceWithAddresses;
+  struct Probe {
+    Time sentAt;
+    uint32_t newestId;  // newest fix in the packet
+  };
+  std::deque<Probe> m_probes;  // packets waiting for their ack, oldest first
+  Time m_minRtt;
+  Time m_nextSlowdown;  // the interval grows at most once per round trip
 };
 
 } // namespace ns3
 
-#endif /* POSITION_CLIENT_H */
+#endif /* CHECKPOINTING_POSITION_CLIENT_H */
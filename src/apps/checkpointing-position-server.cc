@@ -11,9 +11,17 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/vector.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/ipv4.h"
 #include "checkpointing-position-server.h"
+#include "position-batch-codec.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <sstream>
+#include <vector>
 #include <iostream>
 
 namespace ns3 {
@@ -31,6 +39,10 @@ TypeId CheckpointingPositionServer::GetTypeId(void) {
                    UintegerValue(9),
                    MakeUintegerAccessor(&CheckpointingPositionServer::m_port),
                    MakeUintegerChecker<uint16_t>())
+    .AddAttribute("CellOrigin", "Origin the clients encode binary batches against (the eNB position).",
+                   VectorValue(Vector(0, 0, 0)),
+                   MakeVectorAccessor(&CheckpointingPositionServer::m_cellOrigin),
+                   MakeVectorChecker())
     .AddTraceSource("Rx", "A packet has been received",
                      MakeTraceSourceAccessor(&CheckpointingPositionServer::m_rxTrace),
                      "ns3::Packet::TracedCallback")
@@ -51,6 +63,37 @@ CheckpointingPositionServer::~CheckpointingPositionServer() {
   m_socket6 = 0;
 }
 
+bool CheckpointingPositionServer::GetEstimatedPosition(uint32_t nodeId, Vector &position, Time &received) const {
+  auto it = m_lastPositions.find(nodeId);
+  if (it == m_lastPositions.end()) {
+    return false;
+  }
+  position = it->second.position;
+  received = it->second.received;
+  return true;
+}
+
+uint32_t CheckpointingPositionServer::GetSenderNode(const Address &from) {
+  // Clients do not name themselves in their batches, so the node is found
+  // once from the source address and remembered.
+  Ipv4Address address = InetSocketAddress::ConvertFrom(from).GetIpv4();
+  auto it = m_senderNodes.find(address);
+  if (it != m_senderNodes.end()) {
+    return it->second;
+  }
+
+  uint32_t nodeId = UINT32_MAX;
+  for (NodeList::Iterator node = NodeList::Begin(); node != NodeList::End(); ++node) {
+    Ptr<Ipv4> ipv4 = (*node)->GetObject<Ipv4>();
+    if (ipv4 != 0 && ipv4->GetInterfaceForAddress(address) >= 0) {
+      nodeId = (*node)->GetId();
+      break;
+    }
+  }
+  m_senderNodes[address] = nodeId;
+  return nodeId;
+}
+
 void CheckpointingPositionServer::DoDispose(void) {
   NS_LOG_FUNCTION(this);
   Application::DoDispose();
@@ -139,6 +182,11 @@ void  CheckpointingPositionServer::HandleRead(Ptr<Socket> socket) {
     packet->CopyData(msgRaw, size);
     msgRaw[size] = '\0';
     std::string msg = reinterpret_cast<char*>(msgRaw);
+    // Binary batches are logged by size.
+    bool binary = PositionBatchDecoder::IsBinaryBatch(msgRaw, size);
+    if (binary) {
+      msg = "<" + std::to_string(size) + " byte batch>";
+    }
 
     if (InetSocketAddress::IsMatchingType(from)) {
       NS_LOG_INFO("At time " << Simulator::Now().As(Time::S) << " server received '" << msg << "' from " <<
@@ -150,20 +198,56 @@ void  CheckpointingPositionServer::HandleRead(Ptr<Socket> socket) {
                    Inet6SocketAddress::ConvertFrom(from).GetPort());
     }
 
-    std::istringstream batch(msg);
-    std::string line;
-
-    std::ostringstream ack;
-    while (std::getline(batch, line)) {
-      if (line[0] == '.') {
-        break;
+    // Batches list the newest position first, in text as "<id> <x>,<y>,<z>".
+    uint32_t posId;
+    double x, y, z;
+    std::vector<uint32_t> ids;
+    if (binary) {
+      PositionBatchDecoder decoder(msgRaw, size, m_cellOrigin);
+      PositionBatchHeader header;
+      PositionSample sample;
+      if (decoder.ReadHeader(header)) {
+        while (decoder.Next(sample)) {
+          if (ids.empty() && InetSocketAddress::IsMatchingType(from)) {
+            LastReport report = {Vector(sample.x, sample.y, sample.z), Simulator::Now()};
+            m_lastPositions[GetSenderNode(from)] = report;
+          }
+          ids.push_back(sample.id);
+        }
+      }
+    } else {
+      if (InetSocketAddress::IsMatchingType(from) &&
+          std::sscanf(msg.c_str(), "%u %lf,%lf,%lf", &posId, &x, &y, &z) == 4) {
+        LastReport report = {Vector(x, y, z), Simulator::Now()};
+        m_lastPositions[GetSenderNode(from)] = report;
       }
 
-      size_t idSep = line.find(" ");
+      std::istringstream batch(msg);
+      std::string line;
+      while (std::getline(batch, line)) {
+        if (line[0] == '.') {
+          break;
+        }
 
-      if (idSep != std::string::npos) {
-        std::string posIdRaw = line.substr(0, idSep);
-        ack << posIdRaw << " OK\n";
+        if (std::sscanf(line.c_str(), "%u ", &posId) == 1) {
+          ids.push_back(posId);
+        }
+      }
+    }
+
+    // Consecutive ids are acknowledged as one "<first>-<last> OK" line, so
+    // a batch with no gaps takes a single line whatever its size.
+    std::sort(ids.begin(), ids.end());
+    std::ostringstream ack;
+    for (size_t first = 0, last; first < ids.size(); first = last + 1) {
+      last = first;
+      while (last + 1 < ids.size() && ids[last + 1] <= ids[last] + 1) {
+        ++last;
+      }
+      if (ids[first] == ids[last]) {
+        ack << ids[first] << " OK\n";
+      } else {
+        ack << ids[first] << "-" << ids[last] << " OK\n";
       }
     }
 
@@ -6,6 +6,11 @@
 #include "ns3/ptr.h"
 #include "ns3/address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/vector.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+
+#include <map>
 
 namespace ns3 {
 
@@ -18,19 +23,36 @@ public:
   CheckpointingPositionServer();
   virtual ~CheckpointingPositionServer();
 
+  /**
+   * \param nodeId of a client node
+   * \param position filled in with the latest position the node reported
+   * \param received filled in with when that report arrived
+   * \return false if nothing was received from the node yet
+   */
+  bool GetEstimatedPosition(uint32_t nodeId, Vector &position, Time &received) const;
+
 protected:
   virtual void DoDispose(void);
 
 private:
+  struct LastReport {
+    Vector position;
+    Time received;
+  };
+
   virtual void StartApplication(void);
   virtual void StopApplication(void);
 
   void HandleRead(Ptr<Socket> socket);
+  uint32_t GetSenderNode(const Address &from);
 
   uint16_t m_port;
   Ptr<Socket> m_socket;
   Ptr<Socket> m_socket6;
   Address m_local;
+  Vector m_cellOrigin;
+  std::map<Ipv4Address, uint32_t> m_senderNodes;
+  std::map<uint32_t, LastReport> m_lastPositions;
 
   TracedCallback<Ptr<const Packet>> m_rxTrace;
   TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_rxTraceWithAddresses;
@@ -0,0 +1,124 @@
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "coverage-tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("CoverageTracker");
+
+namespace {
+
+// Event times are rounded to the simulator resolution, so a crossing is
+// only known to within this many seconds.
+const double kBoundaryTolerance = 1e-6;
+
+} // namespace
+
+CoverageTracker::CoverageTracker()
+  : m_range(0),
+    m_inside(false) {
+}
+
+CoverageTracker::~CoverageTracker() {
+  Stop();
+}
+
+void CoverageTracker::Start(Ptr<MobilityModel> ue, Ptr<MobilityModel> enb, double range,
+                            TransitionCallback transition) {
+  NS_LOG_FUNCTION(this << range);
+  Stop();
+  m_ue = ue;
+  m_enb = enb;
+  m_range = range;
+  m_transition = transition;
+  m_ue->TraceConnectWithoutContext("CourseChange", MakeCallback(&CoverageTracker::CourseChanged, this));
+
+  m_inside = m_range <= CalculateDistance(m_ue->GetPosition(), m_enb->GetPosition());
+  m_transition(m_inside);
+  ScheduleCrossing();
+}
+
+void CoverageTracker::Stop(void) {
+  Simulator::Cancel(m_crossEvent);
+  if (m_ue != 0) {
+    m_ue->TraceDisconnectWithoutContext("CourseChange", MakeCallback(&CoverageTracker::CourseChanged, this));
+    m_ue = 0;
+    m_enb = 0;
+  }
+}
+
+bool CoverageTracker::IsInside(void) const {
+  return m_inside;
+}
+
+void CoverageTracker::CourseChanged(Ptr<const MobilityModel> model) {
+  NS_LOG_FUNCTION(this);
+  bool inside = m_range <= CalculateDistance(m_ue->GetPosition(), m_enb->GetPosition());
+  if (inside != m_inside) {
+    m_inside = inside;
+    m_transition(m_inside);
+  }
+  ScheduleCrossing();
+}
+
+void CoverageTracker::Cross(void) {
+  NS_LOG_FUNCTION(this);
+  // The event may have been scheduled for a crossing that a later course
+  // change put off; it only flips the state if the UE is at the boundary.
+  // The side is then known from the roots rather than from the distance,
+  // which is the range up to rounding.
+  double t = GetTimeToCrossing();
+  if (t >= 0 && t < kBoundaryTolerance) {
+    m_inside = !m_inside;
+    m_transition(m_inside);
+  }
+  ScheduleCrossing();
+}
+
+void CoverageTracker::ScheduleCrossing(void) {
+  double t = GetTimeToCrossing();
+  if (t < 0) {
+    return;
+  }
+
+  // A course change usually only moves the crossing a little, so a pending
+  // event that is due no later is kept and checks again when it runs.
+  Time at = Seconds(t);
+  if (m_crossEvent.IsRunning() && m_crossEvent.GetTs() <= (Simulator::Now() + at).GetTimeStep()) {
+    return;
+  }
+  Simulator::Cancel(m_crossEvent);
+  m_crossEvent = Simulator::Schedule(at, &CoverageTracker::Cross, this);
+}
+
+double CoverageTracker::GetTimeToCrossing(void) const {
+  // |p + v t| = range, with p relative to the eNB.
+  Vector p = m_ue->GetPosition() - m_enb->GetPosition();
+  Vector v = m_ue->GetVelocity();
+  double a = v.x * v.x + v.y * v.y + v.z * v.z;
+  double b = 2 * (p.x * v.x + p.y * v.y + p.z * v.z);
+  double c = p.x * p.x + p.y * p.y + p.z * p.z - m_range * m_range;
+  double discriminant = b * b - 4 * a * c;
+  if (a == 0) {
+    return -1;
+  }
+
+  // From beyond the range the UE can only cross on its way in, at the
+  // nearer root; from within, it leaves at the farther one. Roots in the
+  // past come from rounding at the boundary and mean now.
+  if (m_inside) {
+    if (b >= 0 || discriminant < 0) {
+      return -1;
+    }
+    return std::max((-b - std::sqrt(discriminant)) / (2 * a), 0.0);
+  }
+  if (discriminant < 0) {
+    return 0;
+  }
+  return std::max((-b + std::sqrt(discriminant)) / (2 * a), 0.0);
+}
+
+} // namespace ns3
@@ -0,0 +1,60 @@
+#ifndef COVERAGE_TRACKER_H
+#define COVERAGE_TRACKER_H
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/mobility-model.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+/**
+ * Follows whether a UE is at least a given distance from its eNB, the test
+ * the clients log as "inside", without polling.
+ *
+ * Between course changes a UE moves in a straight line at constant speed,
+ * so the next time it crosses the circle around the eNB is a root of a
+ * quadratic. The tracker schedules one event at that time and solves again
+ * whenever the mobility model reports a course change, keeping the pending
+ * event if it is still due early enough.
+ */
+class CoverageTracker {
+public:
+  /**
+   * Called with the new state whenever the UE crosses the circle, and once
+   * with the initial state on Start.
+   */
+  typedef Callback<void, bool> TransitionCallback;
+
+  CoverageTracker();
+  ~CoverageTracker();
+
+  void Start(Ptr<MobilityModel> ue, Ptr<MobilityModel> enb, double range, TransitionCallback transition);
+  void Stop(void);
+  /**
+   * \return whether the UE was at least the range from the eNB at the last
+   * transition
+   */
+  bool IsInside(void) const;
+
+private:
+  void CourseChanged(Ptr<const MobilityModel> model);
+  void Cross(void);
+  void ScheduleCrossing(void);
+  /**
+   * \return the seconds until the UE next crosses the circle if it keeps its
+   * course, or a negative value if it never does
+   */
+  double GetTimeToCrossing(void) const;
+
+  Ptr<MobilityModel> m_ue;
+  Ptr<MobilityModel> m_enb;
+  double m_range;
+  TransitionCallback m_transition;
+  bool m_inside;
+  EventId m_crossEvent;
+};
+
+} // namespace ns3
+
+#endif /* COVERAGE_TRACKER_H */
@@ -0,0 +1,48 @@
+#include "dead-reckoning.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+namespace {
+
+// Side of the square the scenarios place vehicles in (cellsize).
+const double kAreaSize = 1000.0;
+
+} // namespace
+
+DeadReckoning::DeadReckoning()
+  : m_speed(0),
+    m_direction(0),
+    m_hasReport(false) {
+}
+
+void DeadReckoning::Report(const Vector &position, double speed, Time taken) {
+  // Two reports at the same spot say nothing about the heading, so the
+  // previous one is kept.
+  if (m_hasReport && (position.x != m_position.x || position.y != m_position.y)) {
+    m_direction = std::atan2(position.y - m_position.y, position.x - m_position.x);
+  }
+  m_position = Vector(position.x, position.y, 0);
+  m_speed = speed;
+  m_taken = taken;
+  m_hasReport = true;
+}
+
+Vector DeadReckoning::Predict(Time at) const {
+  if (m_speed <= 0) {
+    return m_position;
+  }
+
+  // Always from the report itself, so estimates do not build on each other.
+  double distance = m_speed * (at - m_taken).GetSeconds();
+  Vector predicted = m_position;
+  predicted.x += distance * std::cos(m_direction);
+  predicted.y += distance * std::sin(m_direction);
+  predicted.x = std::max(0.0, std::min(kAreaSize, predicted.x));
+  predicted.y = std::max(0.0, std::min(kAreaSize, predicted.y));
+  return predicted;
+}
+
+} // namespace ns3
@@ -0,0 +1,51 @@
+#ifndef DEAD_RECKONING_H
+#define DEAD_RECKONING_H
+
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+/**
+ * The GPS-CBL server's view of a vehicle: its latest report, carried
+ * forward in a straight line at the reported speed, along the heading from
+ * the previous report to the latest one.
+ *
+ * The server keeps one per vehicle. A client sending on deviation keeps a
+ * copy of its own, fed with what it sent, to know what the server predicts
+ * without asking.
+ */
+class DeadReckoning {
+public:
+  DeadReckoning();
+
+  /**
+   * Takes in the newest fix of a batch.
+   * \param position where the fix was taken; only x and y are used
+   * \param speed at the fix, in m/s
+   * \param taken when the fix was taken
+   */
+  void Report(const Vector &position, double speed, Time taken);
+
+  /**
+   * \return whether anything was reported yet
+   */
+  bool HasReport(void) const { return m_hasReport; }
+
+  /**
+   * \return where the vehicle is predicted to be at the given time; the
+   * prediction stays within the scenario area
+   */
+  Vector Predict(Time at) const;
+
+private:
+  Vector m_position;
+  double m_speed;
+  double m_direction;  // radians
+  Time m_taken;
+  bool m_hasReport;
+};
+
+} // namespace ns3
+
+#endif /* DEAD_RECKONING_H */
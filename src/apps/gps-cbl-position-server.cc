@@ -11,8 +11,12 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/vector.h"
 #include "gps-cbl-position-server.h"
+#include "position-batch-codec.h"
 
+#include <cmath>
+#include <cstdio>
 #include <string>
 #include <sstream>
 #include <iostream>
@@ -32,6 +36,10 @@ TypeId GPSCBLPositionServer::GetTypeId(void) {
                    UintegerValue(9),
                    MakeUintegerAccessor(&GPSCBLPositionServer::m_port),
                    MakeUintegerChecker<uint16_t>())
+    .AddAttribute("CellOrigin", "Origin the clients encode binary batches against (the eNB position).",
+                   VectorValue(Vector(0, 0, 0)),
+                   MakeVectorAccessor(&GPSCBLPositionServer::m_cellOrigin),
+                   MakeVectorChecker())
     .AddTraceSource("Rx", "A packet has been received",
                      MakeTraceSourceAccessor(&GPSCBLPositionServer::m_rxTrace),
                      "ns3::Packet::TracedCallback")
@@ -52,6 +60,16 @@ GPSCBLPositionServer::~GPSCBLPositionServer() {
   m_socket6 = 0;
 }
 
+bool GPSCBLPositionServer::GetEstimatedPosition(uint32_t vehicleId, Vector &position, Time &received) const {
+  auto it = m_vehicleStates.find(vehicleId);
+  if (it == m_vehicleStates.end()) {
+    return false;
+  }
+  position = it->second.estimatedPosition;
+  received = it->second.received;
+  return true;
+}
+
 void GPSCBLPositionServer::DoDispose(void) {
   NS_LOG_FUNCTION(this);
   Application::DoDispose();
@@ -104,7 +122,7 @@ void  GPSCBLPositionServer::StartApplication(void) {
 
   m_socket->SetRecvCallback(MakeCallback(&GPSCBLPositionServer::HandleRead, this));
   m_socket6->SetRecvCallback(MakeCallback(&GPSCBLPositionServer::HandleRead, this));
-  Simulator::Schedule(Seconds(1.0), &GPSCBLPositionServer::EstimatePositions, this);
+  m_estimateEvent = Simulator::Schedule(Seconds(1.0), &GPSCBLPositionServer::EstimatePositions, this);
 }
 
 void  GPSCBLPositionServer::StopApplication() {
@@ -119,6 +137,8 @@ void  GPSCBLPositionServer::StopApplication() {
     m_socket6->Close();
     m_socket6->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
   }
+
+  Simulator::Cancel(m_estimateEvent);
 }
 
 void GPSCBLPositionServer::EstimatePositions() {
@@ -128,21 +148,11 @@ void GPSCBLPositionServer::EstimatePositions() {
     uint32_t vehicleId = pair.first;
     VehicleState& state = pair.second;
     
-    if (!state.receivedUpdate && state.lastSpeed > 0) {
-      double elapsed = (currentTime - state.lastUpdate).GetSeconds();
-      double distance = state.lastSpeed * elapsed;
-      Vector predictedPos = state.lastPosition;
-      predictedPos.x += distance * std::cos(state.lastDirection);
-      predictedPos.y += distance * std::sin(state.lastDirection);
-      predictedPos.x = std::max(0.0, std::min(1000.0, predictedPos.x));
-      predictedPos.y = std::max(0.0, std::min(1000.0, predictedPos.y));
-      state.lastPosition = predictedPos;
-      std::cout << "Estimated position for vehicle " << vehicleId 
-                << " at (" << predictedPos.x << ", " << predictedPos.y << ")" << std::endl;
-    }
-    state.receivedUpdate = false;
+    Vector predictedPos = state.reckoning.Predict(currentTime);
+    state.estimatedPosition = predictedPos;
+    NS_LOG_LOGIC("Estimated position for vehicle " << vehicleId << " at (" << predictedPos.x << ", " << predictedPos.y << ")");
   }
-  Simulator::Schedule(Seconds(1), &VehicleTrackingServer::EstimatePositions, this);
+  m_estimateEvent = Simulator::Schedule(Seconds(1), &GPSCBLPositionServer::EstimatePositions, this);
 }
 
 void  GPSCBLPositionServer::HandleRead(Ptr<Socket> socket) {
@@ -165,6 +175,11 @@ void  GPSCBLPositionServer::HandleRead(Ptr<Socket> socket) {
     packet->CopyData(msgRaw, size);
     msgRaw[size] = '\0';
     std::string msg = reinterpret_cast<char*>(msgRaw);
+    // Binary batches are logged by size.
+    bool binary = PositionBatchDecoder::IsBinaryBatch(msgRaw, size);
+    if (binary) {
+      msg = "<" + std::to_string(size) + " byte batch>";
+    }
 
     if (InetSocketAddress::IsMatchingType(from)) {
       NS_LOG_INFO("At time " << Simulator::Now().As(Time::S) << " server received '" << msg << "' from " <<
@@ -176,68 +191,37 @@ void  GPSCBLPositionServer::HandleRead(Ptr<Socket> socket) {
                    Inet6SocketAddress::ConvertFrom(from).GetPort());
     }
 
-    std::istringstream batch(msg);
-    std::string line;
-
-    std::string vehIdRaw;
-    std::string posIdRaw;
-    double xRaw;
-    double yRaw;
-    double speedRaw;
-
-    while (std::getline(batch, line)) {
-      if (line[0] == '.') {
-        break;
-      }
-
-      for (int i = 0; i < 3; i++) {
-        size_t idSep = line.find(" ");
-
-        if (idSep != std::string::npos) {
-          if (i == 0) {
-            vehIdRaw = line.substr(0, idSep);
-          } else if (i == 1) {
-            posIdRaw = line.substr(0, idSep);
-          } else if (i == 2) {
-            std::string raw = line.substr(0, idSep);
-            size_t idSep1 = line.find(",");
-            xRaw = raw.substr(0, idSep1);
-
-            raw = raw.substr(idSep1 + 1, raw.length());
-            size_t idSep2 = line.find(",");
-            yRaw = raw.substr(0, idSep2);
-
-            raw = raw.substr(idSep2 + 1, raw.length());
-            size_t idSep3 = line.find(";");
-            speedRaw = line.substr(idSep3, idSep);
-          }
-
-          line = line.substr(idSep + 1, line.length());
-        }
+    // The first line carries the vehicle id and the newest position:
+    // "<vehicle> <id> <x>,<y>,<z>;<speed>". Older positions follow, one per line.
+    // Binary batches also carry when each position was taken.
+    uint32_t vehicleId;
+    double x, y, speed;
+    Time taken = Simulator::Now();
+    PositionBatchDecoder decoder(msgRaw, size, m_cellOrigin);
+    PositionBatchHeader header;
+    PositionSample newest;
+    if (binary) {
+      if (!decoder.ReadHeader(header) || !(header.flags & kPositionBatchNode) || !decoder.Next(newest)) {
+        NS_LOG_WARN("Malformed batch " << msg);
+        delete[] msgRaw;
+        continue;
       }
+      vehicleId = header.nodeId;
+      x = newest.x;
+      y = newest.y;
+      speed = newest.speed;
+      taken = TimeStep(newest.timestamp);
+    } else if (std::sscanf(msg.c_str(), "%u %u %lf,%lf,%lf;%lf", &vehicleId, &newest.id, &x, &y, &newest.z, &speed) != 6) {
+      NS_LOG_WARN("Malformed batch '" << msg << "'");
+      delete[] msgRaw;
+      continue;
     }
 
-    uint32_t vehicleId = static_cast<uint32_t>(std::stoul(vehIdRaw));
-    double x = std::stod(xRaw);
-    double y = std::stod(yRaw);
-    double speed = std::stod(speedRaw);
-    
-    VehicleState state;
-    state.lastPosition = Vector(x, y, 0);
-    state.lastSpeed = speed;
-    state.lastUpdate = Simulator::Now();
-    state.receivedUpdate = true;
-    
-    if (m_vehicleStates.find(vehicleId) != m_vehicleStates.end()) {
-      Vector prevPos = m_vehicleStates[vehicleId].lastPosition;
-      double dx = x - prevPos.x;
-      double dy = y - prevPos.y;
-      state.lastDirection = std::atan2(dy, dx);
-    }
-    
-    m_vehicleStates[vehicleId] = state;
-    std::cout << "Received update from vehicle " << vehicleId 
-              << " at (" << x << ", " << y << ")" << std::endl;
+    VehicleState &state = m_vehicleStates[vehicleId];
+    state.reckoning.Report(Vector(x, y, 0), speed, taken);
+    state.estimatedPosition = Vector(x, y, 0);
+    state.received = Simulator::Now();
+    NS_LOG_LOGIC("Received update from vehicle " << vehicleId << " at (" << x << ", " << y << ")");
 
     delete[] msgRaw;
   }
@@ -6,6 +6,11 @@
 #include "ns3/ptr.h"
 #include "ns3/address.h"
 #include "ns3/traced-callback.h"
+#include "ns3/vector.h"
+#include "ns3/nstime.h"
+#include "dead-reckoning.h"
+
+#include <map>
 
 namespace ns3 {
 
@@ -18,17 +23,23 @@ public:
   GPSCBLPositionServer();
   virtual ~GPSCBLPositionServer();
 
+  /**
+   * \param vehicleId a client reports itself as
+   * \param position filled in with where the server currently believes the
+   * vehicle is: its latest report, moved forward by dead reckoning
+   * \param received filled in with when that report arrived
+   * \return false if nothing was received from the vehicle yet
+   */
+  bool GetEstimatedPosition(uint32_t vehicleId, Vector &position, Time &received) const;
+
 protected:
   virtual void DoDispose(void);
 
 private:
   struct VehicleState {
-    uint32_t id;
-    Vector lastPosition;
-    double lastSpeed = 0;
-    double lastDirection = 0;
-    Time lastUpdate;
-    bool receivedUpdate = false;
+    DeadReckoning reckoning;
+    Vector estimatedPosition;
+    Time received;
   };
   
   virtual void StartApplication(void);
@@ -41,6 +52,8 @@ private:
   Ptr<Socket> m_socket;
   Ptr<Socket> m_socket6;
   Address m_local;
+  Vector m_cellOrigin;
+  EventId m_estimateEvent;
   std::map<uint32_t, VehicleState> m_vehicleStates;
 
   TracedCallback<Ptr<const Packet>> m_rxTrace;
@@ -0,0 +1,333 @@
+#include "ns3/assert.h"
+#include "position-backlog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+namespace {
+
+// Send time of fixes never sent or marked lost.
+const int64_t kNotSent = std::numeric_limits<int64_t>::min();
+// Priority of fixes that cannot be evicted.
+const double kNoPriority = std::numeric_limits<double>::infinity();
+
+// Distance between a fix and where the vehicle would be at the same time
+// moving straight from the fix before it to the fix after it.
+double SynchronizedDistance(const PositionSample &before, const PositionSample &sample,
+                            const PositionSample &after) {
+  double ratio = 0;
+  if (after.timestamp != before.timestamp) {
+    ratio = static_cast<double>(sample.timestamp - before.timestamp) / (after.timestamp - before.timestamp);
+  }
+  double x = before.x + (after.x - before.x) * ratio;
+  double y = before.y + (after.y - before.y) * ratio;
+  return std::hypot(sample.x - x, sample.y - y);
+}
+
+} // namespace
+
+PositionBacklog::PositionBacklog()
+  : m_entries(16),
+    m_mask(15),
+    m_head(0),
+    m_size(0),
+    m_pending(0),
+    m_maxSamples(0),
+    m_maxBytes(0),
+    m_tolerance(0),
+    m_limited(false),
+    m_bytes(0),
+    m_evicted(0),
+    m_maxEvictedError(0) {
+}
+
+void PositionBacklog::SetLimits(uint32_t maxSamples, uint32_t maxBytes, double tolerance) {
+  NS_ASSERT_MSG(m_size == 0, "limits must be set before the first fix");
+  m_maxSamples = maxSamples;
+  m_maxBytes = maxBytes;
+  m_tolerance = tolerance;
+  m_limited = maxSamples > 0 || maxBytes > 0 || tolerance > 0;
+}
+
+void PositionBacklog::Push(const PositionSample &sample) {
+  NS_ASSERT_MSG(m_size == 0 || static_cast<int32_t>(sample.id - At(m_size - 1).sample.id) > 0,
+                "fixes must be pushed in id order");
+
+  if (m_size == m_entries.size()) {
+    // Compacting frees at least half of the ring, so each fix is moved a
+    // bounded number of times; otherwise the ring doubles.
+    if (m_size - m_pending >= m_size / 2) {
+      Compact();
+    } else {
+      Grow();
+    }
+  }
+  Entry &entry = At(m_size);
+  entry.sample = sample;
+  entry.sentAt = kNotSent;
+  entry.priority = kNoPriority;
+  entry.error = 0;
+  entry.bytes = 0;
+  entry.acked = 0;
+  entry.transmissions = 0;
+  if (m_maxBytes > 0) {
+    m_line.clear();
+    AppendPositionSample(m_line, sample, false);
+    entry.bytes = m_line.size();
+    m_bytes += entry.bytes;
+  }
+  ++m_size;
+  ++m_pending;
+
+  if (m_limited) {
+    // The newest fix so far now has a neighbour on both sides.
+    Prioritize(PreviousPending(m_size - 1));
+    EnforceLimits();
+  }
+}
+
+void PositionBacklog::AckUpTo(uint32_t lastId) {
+  // Ids are compared through their difference, so the comparison still
+  // holds when they wrap around.
+  while (m_size > 0 && static_cast<int32_t>(At(0).sample.id - lastId) <= 0) {
+    if (!At(0).acked) {
+      Release(0);
+    }
+    m_head = (m_head + 1) & m_mask;
+    --m_size;
+  }
+  Retire();
+  if (m_limited) {
+    // The oldest pending fix may have changed, and it cannot be evicted.
+    Prioritize(0);
+  }
+}
+
+void PositionBacklog::AckRange(uint32_t firstId, uint32_t lastId) {
+  if (m_size == 0 || static_cast<int32_t>(firstId - At(0).sample.id) <= 0) {
+    AckUpTo(lastId);
+    return;
+  }
+
+  uint32_t first = LowerBound(firstId);
+  for (uint32_t i = first; i < m_size && static_cast<int32_t>(At(i).sample.id - lastId) <= 0; ++i) {
+    if (!At(i).acked) {
+      Release(i);
+    }
+  }
+  if (m_limited && first < m_size) {
+    // The fixes around the range have new neighbours.
+    Prioritize(PreviousPending(first));
+    Prioritize(NextPending(first));
+  }
+}
+
+PositionBacklog::Selection PositionBacklog::SelectDue(int64_t now, int64_t rto, uint32_t window) {
+  Selection selection = {0, 0, 0, 0};
+  m_selected.clear();
+
+  // Fixes sent within the timeout are in flight and take up the window
+  // wherever they are, so they are counted before anything is picked.
+  uint32_t inFlight = 0;
+  for (uint32_t i = 0; i < m_size; ++i) {
+    const Entry &entry = At(i);
+    if (!entry.acked && entry.sentAt != kNotSent && now - entry.sentAt < rto) {
+      ++inFlight;
+    }
+  }
+
+  for (uint32_t i = 0; i < m_size; ++i) {
+    const Entry &entry = At(i);
+    if (entry.acked || (entry.sentAt != kNotSent && now - entry.sentAt < rto)) {
+      continue;
+    }
+    if (inFlight + m_selected.size() >= window) {
+      ++selection.leftOut;
+      continue;
+    }
+    m_selected.push_back((m_head + i) & m_mask);
+    if (entry.transmissions > 0) {
+      ++selection.retransmissions;
+      if (entry.sentAt != kNotSent) {
+        ++selection.timedOut;
+      }
+    }
+  }
+  selection.count = m_selected.size();
+  return selection;
+}
+
+void PositionBacklog::MarkSelectedSent(int64_t now) {
+  for (uint32_t slot : m_selected) {
+    Entry &entry = m_entries[slot];
+    entry.sentAt = now;
+    if (entry.transmissions < std::numeric_limits<uint8_t>::max()) {
+      ++entry.transmissions;
+    }
+  }
+  m_selected.clear();
+}
+
+void PositionBacklog::MarkLostBefore(int64_t sentAt) {
+  for (uint32_t i = 0; i < m_size; ++i) {
+    Entry &entry = At(i);
+    if (!entry.acked && entry.sentAt != kNotSent && entry.sentAt < sentAt) {
+      entry.sentAt = kNotSent;
+    }
+  }
+}
+
+bool PositionBacklog::GetSingleTransmission(uint32_t id, int64_t &sentAt) const {
+  uint32_t i = LowerBound(id);
+  if (i == m_size) {
+    return false;
+  }
+  const Entry &entry = At(i);
+  if (entry.sample.id != id || entry.acked || entry.transmissions != 1 || entry.sentAt == kNotSent) {
+    return false;
+  }
+  sentAt = entry.sentAt;
+  return true;
+}
+
+void PositionBacklog::Clear() {
+  m_head = 0;
+  m_size = 0;
+  m_pending = 0;
+  m_bytes = 0;
+  m_evictable.clear();
+  m_selected.clear();
+}
+
+uint32_t PositionBacklog::LowerBound(uint32_t id) const {
+  if (m_size == 0) {
+    return 0;
+  }
+  uint32_t oldest = At(0).sample.id;
+  if (static_cast<int32_t>(id - oldest) <= 0) {
+    return 0;
+  }
+  uint32_t low = 0;
+  uint32_t high = m_size;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    if (At(middle).sample.id - oldest < id - oldest) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+uint32_t PositionBacklog::PreviousPending(uint32_t i) const {
+  while (i-- > 0) {
+    if (!At(i).acked) {
+      return i;
+    }
+  }
+  return m_size;
+}
+
+uint32_t PositionBacklog::NextPending(uint32_t i) const {
+  while (++i < m_size) {
+    if (!At(i).acked) {
+      return i;
+    }
+  }
+  return m_size;
+}
+
+void PositionBacklog::Release(uint32_t i) {
+  Entry &entry = At(i);
+  if (entry.priority != kNoPriority) {
+    m_evictable.erase(std::make_pair(entry.priority, entry.sample.id));
+    entry.priority = kNoPriority;
+  }
+  entry.acked = 1;
+  m_bytes -= entry.bytes;
+  --m_pending;
+}
+
+void PositionBacklog::Prioritize(uint32_t i) {
+  if (i >= m_size) {
+    return;
+  }
+  Entry &entry = At(i);
+  if (entry.priority != kNoPriority) {
+    m_evictable.erase(std::make_pair(entry.priority, entry.sample.id));
+    entry.priority = kNoPriority;
+  }
+  if (entry.acked) {
+    return;
+  }
+
+  uint32_t before = PreviousPending(i);
+  uint32_t after = NextPending(i);
+  if (before == m_size || after == m_size) {
+    return;
+  }
+  entry.priority = entry.error + SynchronizedDistance(At(before).sample, entry.sample, At(after).sample);
+  m_evictable.insert(std::make_pair(entry.priority, entry.sample.id));
+}
+
+void PositionBacklog::Evict(uint32_t i) {
+  double priority = At(i).priority;
+  Release(i);
+  ++m_evicted;
+  m_maxEvictedError = std::max(m_maxEvictedError, priority);
+
+  // SQUISH-E: the neighbours inherit the error made by leaving this fix
+  // out, so errors from successive evictions add up instead of hiding.
+  uint32_t before = PreviousPending(i);
+  uint32_t after = NextPending(i);
+  At(before).error = std::max(At(before).error, priority);
+  At(after).error = std::max(At(after).error, priority);
+  Prioritize(before);
+  Prioritize(after);
+}
+
+void PositionBacklog::EnforceLimits() {
+  while (!m_evictable.empty()) {
+    bool over = (m_maxSamples > 0 && m_pending > m_maxSamples) || (m_maxBytes > 0 && m_bytes > m_maxBytes);
+    if (!over && m_evictable.begin()->first >= m_tolerance) {
+      break;
+    }
+    Evict(LowerBound(m_evictable.begin()->second));
+  }
+}
+
+void PositionBacklog::Grow() {
+  std::vector<Entry> entries(m_entries.size() * 2);
+  for (uint32_t i = 0; i < m_size; ++i) {
+    entries[i] = At(i);
+  }
+  m_entries.swap(entries);
+  m_mask = m_entries.size() - 1;
+  m_head = 0;
+  m_selected.clear();
+}
+
+void PositionBacklog::Retire() {
+  // Fixes acknowledged out of order leave once everything older has.
+  while (m_size > 0 && At(0).acked) {
+    m_head = (m_head + 1) & m_mask;
+    --m_size;
+  }
+}
+
+void PositionBacklog::Compact() {
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < m_size; ++i) {
+    if (!At(i).acked) {
+      At(kept++) = At(i);
+    }
+  }
+  m_size = kept;
+  m_selected.clear();
+}
+
+} // namespace ns3
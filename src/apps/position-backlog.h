@@ -0,0 +1,194 @@
+#ifndef POSITION_BACKLOG_H
+#define POSITION_BACKLOG_H
+
+#include "position-sample.h"
+
+#include <set>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Fixes a client has taken but the server has not acknowledged yet.
+ *
+ * The backlog is a ring buffer of fixes in id order: appending is
+ * amortized O(1), and so is acknowledging, since every fix is retired
+ * exactly once when the oldest pending one moves forward. Fixes
+ * acknowledged out of order, or evicted, are only marked until then, or
+ * until the marked ones outnumber the pending ones and the ring is
+ * compacted; ids are looked up by binary search.
+ *
+ * For windowed retransmission it also remembers when each fix was last
+ * sent and how often, so fixes are resent one by one as their own
+ * timeouts expire instead of with the whole backlog.
+ *
+ * The backlog can be bounded in fixes and in bytes. Past the bound it
+ * evicts fixes online with SQUISH-E: each pending fix has a priority, the
+ * synchronized distance between it and the line through its neighbours at
+ * the time it was taken, plus the largest priority of the neighbours
+ * evicted before it. The fix with the lowest priority goes first, so the
+ * route keeps its shape as long as possible, and the oldest and newest
+ * pending fixes always stay.
+ */
+class PositionBacklog {
+public:
+  PositionBacklog();
+
+  /**
+   * Bounds the pending fixes.
+   * \param maxSamples fixes kept at most, 0 for no bound
+   * \param maxBytes bytes the fixes would take in a text batch at most, 0
+   * for no bound
+   * \param tolerance fixes whose priority is below this many meters are
+   * evicted even within the bounds, 0 to only evict past them
+   */
+  void SetLimits(uint32_t maxSamples, uint32_t maxBytes, double tolerance);
+
+  /**
+   * Appends a fix; its id must be newer than the id of the last fix
+   * pushed. Evicts fixes if the backlog goes past its limits.
+   */
+  void Push(const PositionSample &sample);
+  /**
+   * Acknowledges every fix up to and including lastId.
+   */
+  void AckUpTo(uint32_t lastId);
+  /**
+   * Acknowledges the fixes from firstId to lastId, inclusive. A range that
+   * reaches back to the oldest pending fix is a cumulative acknowledgement.
+   */
+  void AckRange(uint32_t firstId, uint32_t lastId);
+  void Clear();
+
+  /**
+   * \return the number of fixes not acknowledged yet
+   */
+  uint32_t GetNPending() const { return m_pending; }
+  /**
+   * \return the number of fixes evicted since the backlog was created
+   */
+  uint32_t GetNEvicted() const { return m_evicted; }
+  /**
+   * \return the highest priority a fix was evicted with, in meters
+   */
+  double GetMaxEvictedError() const { return m_maxEvictedError; }
+
+  /**
+   * What SelectDue picked.
+   */
+  struct Selection {
+    uint32_t count;            // fixes selected
+    uint32_t retransmissions;  // of those, fixes sent before
+    uint32_t timedOut;         // of those, fixes resent because rto expired
+    uint32_t leftOut;          // fixes due but over the window
+  };
+
+  /**
+   * Selects the pending fixes due for sending: those never sent, those
+   * marked lost and those last sent at least rto ago. The oldest go first,
+   * and only as many as keep the fixes in flight within window. The
+   * selection holds until the next Push or acknowledgement.
+   * \param now current time step
+   * \param rto retransmission timeout, in time steps
+   * \param window fixes allowed in flight
+   */
+  Selection SelectDue(int64_t now, int64_t rto, uint32_t window);
+  /**
+   * Records that the fixes from the last SelectDue were sent at now.
+   */
+  void MarkSelectedSent(int64_t now);
+  /**
+   * Marks every pending fix last sent before sentAt as lost, so the next
+   * SelectDue picks it right away.
+   */
+  void MarkLostBefore(int64_t sentAt);
+  /**
+   * \param id of a fix
+   * \param sentAt set to when the fix was sent
+   * \return whether the fix is pending and was sent exactly once, so that
+   * its acknowledgement times the round trip unambiguously
+   */
+  bool GetSingleTransmission(uint32_t id, int64_t &sentAt) const;
+
+  /**
+   * Calls visit(const PositionSample &) on the fixes from the last
+   * SelectDue, newest first.
+   */
+  template <typename Visitor>
+  void VisitSelectedNewestFirst(Visitor visit) const {
+    for (uint32_t i = m_selected.size(); i-- > 0;) {
+      visit(m_entries[m_selected[i]].sample);
+    }
+  }
+
+  /**
+   * Calls visit(const PositionSample &) on every pending fix, newest first.
+   */
+  template <typename Visitor>
+  void VisitNewestFirst(Visitor visit) const {
+    for (uint32_t i = m_size; i-- > 0;) {
+      const Entry &entry = At(i);
+      if (!entry.acked) {
+        visit(entry.sample);
+      }
+    }
+  }
+
+private:
+  struct Entry {
+    PositionSample sample;
+    int64_t sentAt;         // kNotSent when due right away
+    double priority;        // kNoPriority when it cannot be evicted
+    double error;           // largest priority of the neighbours evicted
+    uint16_t bytes;         // in a text batch, when bytes are bounded
+    uint8_t acked;          // acknowledged or evicted
+    uint8_t transmissions;
+  };
+
+  Entry &At(uint32_t i) { return m_entries[(m_head + i) & m_mask]; }
+  const Entry &At(uint32_t i) const { return m_entries[(m_head + i) & m_mask]; }
+  /**
+   * \return the position of the first fix kept with an id not older than
+   * id, or m_size if there is none
+   */
+  uint32_t LowerBound(uint32_t id) const;
+  /**
+   * \return the position of the pending fix before or after i, or m_size
+   * if there is none
+   */
+  uint32_t PreviousPending(uint32_t i) const;
+  uint32_t NextPending(uint32_t i) const;
+  /**
+   * Takes the pending fix at i out of the accounting and marks it.
+   */
+  void Release(uint32_t i);
+  void Prioritize(uint32_t i);
+  void Evict(uint32_t i);
+  void EnforceLimits();
+  void Grow();
+  void Retire();
+  void Compact();
+
+  std::vector<Entry> m_entries;
+  std::vector<uint32_t> m_selected;  // slots, oldest first
+  uint32_t m_mask;      // capacity - 1, the capacity being a power of two
+  uint32_t m_head;      // slot of the oldest fix kept
+  uint32_t m_size;      // fixes kept, acknowledged or not
+  uint32_t m_pending;   // fixes kept and not acknowledged
+
+  uint32_t m_maxSamples;
+  uint32_t m_maxBytes;
+  double m_tolerance;
+  bool m_limited;
+  uint32_t m_bytes;     // of the pending fixes, when bytes are bounded
+  std::set<std::pair<double, uint32_t>> m_evictable;  // priority, id
+  std::vector<uint8_t> m_line;
+  uint32_t m_evicted;
+  double m_maxEvictedError;
+};
+
+} // namespace ns3
+
+#endif /* POSITION_BACKLOG_H */
@@ -0,0 +1,160 @@
+#include "ns3/nstime.h"
+#include "position-batch-codec.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+namespace {
+
+const double kPositionScale = 10;  // fixed-point steps per meter
+const double kSpeedScale = 10;     // fixed-point steps per m/s
+const int kNFields = 6;            // id, time, x, y, z, speed
+
+// Linear extrapolation once two fixes are known, the previous value after
+// the first one.
+int64_t Predict(uint32_t index, int64_t prev, int64_t prevPrev) {
+  if (index == 0) {
+    return 0;
+  }
+  if (index == 1) {
+    return prev;
+  }
+  return 2 * prev - prevPrev;
+}
+
+void WriteVarint(std::vector<uint8_t> &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t ZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+} // namespace
+
+PositionBatchEncoder::PositionBatchEncoder(std::vector<uint8_t> &out, const PositionBatchHeader &header,
+                                           const Vector &origin)
+  : m_out(out),
+    m_origin(origin),
+    m_withSpeed(header.flags & kPositionBatchSpeed),
+    m_added(0) {
+  std::fill(m_prev, m_prev + kNFields, 0);
+  std::fill(m_prevPrev, m_prevPrev + kNFields, 0);
+  m_out.push_back(kPositionBatchTag | header.flags);
+  WriteVarint(m_out, header.count);
+  if (header.flags & kPositionBatchNode) {
+    WriteVarint(m_out, header.nodeId);
+  }
+}
+
+void PositionBatchEncoder::Add(const PositionSample &sample) {
+  int64_t fields[kNFields] = {
+    sample.id,
+    TimeStep(sample.timestamp).GetMilliSeconds(),
+    std::llround((sample.x - m_origin.x) * kPositionScale),
+    std::llround((sample.y - m_origin.y) * kPositionScale),
+    std::llround((sample.z - m_origin.z) * kPositionScale),
+    std::llround(sample.speed * kSpeedScale)
+  };
+
+  int n = m_withSpeed ? kNFields : kNFields - 1;
+  for (int f = 0; f < n; ++f) {
+    WriteVarint(m_out, ZigZag(fields[f] - Predict(m_added, m_prev[f], m_prevPrev[f])));
+    m_prevPrev[f] = m_prev[f];
+    m_prev[f] = fields[f];
+  }
+  ++m_added;
+}
+
+PositionBatchDecoder::PositionBatchDecoder(const uint8_t *data, size_t size, const Vector &origin)
+  : m_data(data),
+    m_end(data + size),
+    m_origin(origin),
+    m_withSpeed(false),
+    m_remaining(0),
+    m_read(0) {
+  std::fill(m_prev, m_prev + kNFields, 0);
+  std::fill(m_prevPrev, m_prevPrev + kNFields, 0);
+}
+
+bool PositionBatchDecoder::IsBinaryBatch(const uint8_t *data, size_t size) {
+  return size > 0 && (data[0] & 0xfc) == kPositionBatchTag;
+}
+
+bool PositionBatchDecoder::ReadHeader(PositionBatchHeader &header) {
+  if (!IsBinaryBatch(m_data, m_end - m_data)) {
+    return false;
+  }
+  header.flags = *m_data++ & ~kPositionBatchTag;
+  header.nodeId = 0;
+
+  uint64_t value;
+  if (!ReadVarint(value)) {
+    return false;
+  }
+  header.count = value;
+  if (header.flags & kPositionBatchNode) {
+    if (!ReadVarint(value)) {
+      return false;
+    }
+    header.nodeId = value;
+  }
+
+  m_withSpeed = header.flags & kPositionBatchSpeed;
+  m_remaining = header.count;
+  m_read = 0;
+  return true;
+}
+
+bool PositionBatchDecoder::Next(PositionSample &sample) {
+  if (m_remaining == 0) {
+    return false;
+  }
+
+  int64_t fields[kNFields] = {0, 0, 0, 0, 0, 0};
+  int n = m_withSpeed ? kNFields : kNFields - 1;
+  for (int f = 0; f < n; ++f) {
+    uint64_t value;
+    if (!ReadVarint(value)) {
+      m_remaining = 0;
+      return false;
+    }
+    fields[f] = UnZigZag(value) + Predict(m_read, m_prev[f], m_prevPrev[f]);
+    m_prevPrev[f] = m_prev[f];
+    m_prev[f] = fields[f];
+  }
+  --m_remaining;
+  ++m_read;
+
+  sample.id = fields[0];
+  sample.timestamp = MilliSeconds(fields[1]).GetTimeStep();
+  sample.x = m_origin.x + fields[2] / kPositionScale;
+  sample.y = m_origin.y + fields[3] / kPositionScale;
+  sample.z = m_origin.z + fields[4] / kPositionScale;
+  sample.speed = fields[5] / kSpeedScale;
+  return true;
+}
+
+bool PositionBatchDecoder::ReadVarint(uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && m_data < m_end; shift += 7) {
+    uint8_t byte = *m_data++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace ns3
@@ -0,0 +1,93 @@
+#ifndef POSITION_BATCH_CODEC_H
+#define POSITION_BATCH_CODEC_H
+
+#include "ns3/vector.h"
+#include "position-sample.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Binary alternative to the text batches the clients send.
+ *
+ * A batch starts with a tag byte (kPositionBatchTag plus flags), which text
+ * batches never start with, then the number of fixes and, if flagged, the
+ * node id, all as varints. The fixes follow newest first, like in text.
+ *
+ * Every field of a fix (id, timestamp in ms, x, y and z in dm relative to
+ * the cell origin and, if flagged, speed in dm/s) is written as the zig-zag
+ * varint of its difference to a linear prediction from the two previous
+ * fixes. Fixes are taken at a steady pace and vehicles move smoothly, so
+ * most of these differences fit in a single byte.
+ */
+const uint8_t kPositionBatchTag = 0xb0;
+const uint8_t kPositionBatchSpeed = 0x01;  // fixes carry a speed
+const uint8_t kPositionBatchNode = 0x02;   // the node id follows the count
+
+struct PositionBatchHeader {
+  uint32_t count;
+  uint8_t flags;
+  uint32_t nodeId;  // only meaningful with kPositionBatchNode
+};
+
+class PositionBatchEncoder {
+public:
+  /**
+   * Appends the header to out; exactly header.count fixes must follow.
+   * \param origin of the cell, which the server must share
+   */
+  PositionBatchEncoder(std::vector<uint8_t> &out, const PositionBatchHeader &header, const Vector &origin);
+
+  void Add(const PositionSample &sample);
+
+private:
+  std::vector<uint8_t> &m_out;
+  Vector m_origin;
+  bool m_withSpeed;
+  uint32_t m_added;
+  int64_t m_prev[6];
+  int64_t m_prevPrev[6];
+};
+
+class PositionBatchDecoder {
+public:
+  /**
+   * \param origin of the cell the batch was encoded against
+   */
+  PositionBatchDecoder(const uint8_t *data, size_t size, const Vector &origin);
+
+  /**
+   * \return whether data holds a binary batch rather than a text one
+   */
+  static bool IsBinaryBatch(const uint8_t *data, size_t size);
+
+  /**
+   * Reads the header; must come before Next.
+   * \return false if the batch is malformed
+   */
+  bool ReadHeader(PositionBatchHeader &header);
+  /**
+   * Reads the next fix, newest first.
+   * \return false once every fix was read or if the batch is malformed
+   */
+  bool Next(PositionSample &sample);
+
+private:
+  bool ReadVarint(uint64_t &value);
+
+  const uint8_t *m_data;
+  const uint8_t *m_end;
+  Vector m_origin;
+  bool m_withSpeed;
+  uint32_t m_remaining;
+  uint32_t m_read;
+  int64_t m_prev[6];
+  int64_t m_prevPrev[6];
+};
+
+} // namespace ns3
+
+#endif /* POSITION_BATCH_CODEC_H */
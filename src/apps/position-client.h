@@ -0,0 +1,678 @@
+#ifndef POSITION_CLIENT_H
+#define POSITION_CLIENT_H
+
+#include "ns3/application.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/event-id.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/traced-callback.h"
+#include "ns3/uinteger.h"
+#include "ns3/vector.h"
+#include "adaptive-sampler.h"
+#include "batch-policy.h"
+#include "coverage-tracker.h"
+#include "position-batch-codec.h"
+#include "position-packer.h"
+#include "position-packet.h"
+#include "position-sample.h"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Batches of bare fixes, as the simple and checkpointing servers read
+ * them.
+ */
+struct PositionCodec {
+  static const bool kSpeed = false;  // whether fixes are taken with their speed
+
+  static PositionBatchFormat GetFormat(bool binary, uint32_t vehicleId, const Vector &origin) {
+    PositionBatchFormat format = {binary, {0, 0, 0}, origin, 0};
+    return format;
+  }
+
+  /**
+   * Appends fixes[0, count), given oldest first, to payload newest first.
+   */
+  static void Encode(std::vector<uint8_t> &payload, const PositionSample *fixes, uint32_t count,
+                     const PositionBatchFormat &format) {
+    if (format.binary) {
+      PositionBatchHeader header = format.header;
+      header.count = count;
+      PositionBatchEncoder encoder(payload, header, format.origin);
+      for (uint32_t i = count; i-- > 0;) {
+        encoder.Add(fixes[i]);
+      }
+    } else {
+      for (uint32_t i = count; i-- > 0;) {
+        AppendPositionSample(payload, fixes[i], false);
+      }
+    }
+  }
+};
+
+/**
+ * Batches that also carry the vehicle id and the speed of every fix, which
+ * the GPS-CBL server extrapolates from. The id goes where the batch format
+ * has the node id.
+ */
+struct NodePositionCodec {
+  static const bool kSpeed = true;
+
+  static PositionBatchFormat GetFormat(bool binary, uint32_t vehicleId, const Vector &origin) {
+    // Text batches start with the vehicle id and a space and end with a space.
+    char prefix[16];
+    uint32_t textOverhead = std::snprintf(prefix, sizeof(prefix), "%u ", vehicleId) + 1;
+    PositionBatchFormat format = {binary, {0, kPositionBatchSpeed | kPositionBatchNode, vehicleId}, origin,
+                                  textOverhead};
+    return format;
+  }
+
+  static void Encode(std::vector<uint8_t> &payload, const PositionSample *fixes, uint32_t count,
+                     const PositionBatchFormat &format) {
+    if (format.binary) {
+      PositionBatchHeader header = format.header;
+      header.count = count;
+      PositionBatchEncoder encoder(payload, header, format.origin);
+      for (uint32_t i = count; i-- > 0;) {
+        encoder.Add(fixes[i]);
+      }
+    } else {
+      char prefix[16];
+      int size = std::snprintf(prefix, sizeof(prefix), "%u ", format.header.nodeId);
+      payload.insert(payload.end(), prefix, prefix + size);
+      for (uint32_t i = count; i-- > 0;) {
+        AppendPositionSample(payload, fixes[i], true);
+      }
+      payload.push_back(' ');
+    }
+  }
+};
+
+/**
+ * What every position client does the same way: the socket, gathering
+ * fixes, logging coverage, and encoding, padding and splitting batches
+ * into packets.
+ *
+ * Client is the application deriving from it, which decides what happens
+ * to a fix once taken and when the send timer expires; Codec is how
+ * batches are written. Both are resolved at compile time, so the per-fix
+ * and per-packet paths call them directly instead of through a virtual
+ * call. How often fixes are taken and when a batch is due stay the
+ * AdaptiveSampler and BatchPolicy attributes, which scenarios pick at run
+ * time.
+ *
+ * Client must implement
+ *   void Keep(const PositionSample &sample), for every fix taken, and
+ *   void Send(void), when the send timer expires.
+ * It may hide any of these, which default to
+ *   void OnStart(void), doing nothing,
+ *   void OnStop(void), doing nothing,
+ *   bool SendsOnTimer(void) const, true,
+ *   bool TracksCoverage(void) const, false,
+ *   void OnCoverageChanged(bool inside), doing nothing,
+ *   void OnTransmit(const PositionSample &newest), doing nothing, and
+ *   void OnLost(uint32_t count) const, logging "Package lost".
+ * Hooks are reached through Self() and hidden by name, not overridden, so
+ * none is virtual; a client that keeps them private befriends this class.
+ */
+template <typename Client, typename Codec>
+class PositionClient : public Application {
+public:
+  /**
+   * Adds the attributes and trace sources every client has to tid.
+   */
+  static TypeId AddAttributes(TypeId tid);
+
+  /**
+   * \param logComponent of the client, which the shared code logs to
+   */
+  explicit PositionClient(const std::string &logComponent);
+  virtual ~PositionClient();
+
+protected:
+  virtual void DoDispose(void);
+
+  /**
+   * Called once the socket is connected and before any timer starts.
+   */
+  void OnStart(void) {}
+  /**
+   * Called last when the application stops.
+   */
+  void OnStop(void) {}
+  /**
+   * \return whether Send runs every Interval from the start
+   */
+  bool SendsOnTimer(void) const { return true; }
+  /**
+   * \return whether the client needs coverage changes even while they are
+   * not logged as they happen
+   */
+  bool TracksCoverage(void) const { return false; }
+  void OnCoverageChanged(bool inside) {}
+  /**
+   * Called before each packet goes out, lost or not.
+   * \param newest fix in the packet
+   */
+  void OnTransmit(const PositionSample &newest) {}
+  /**
+   * Called for each packet lost out of coverage.
+   * \param count fixes in the packet
+   */
+  void OnLost(uint32_t count) const;
+
+  Client &Self(void) { return static_cast<Client &>(*this); }
+  const Client &Self(void) const { return static_cast<const Client &>(*this); }
+
+  void ScheduleTransmit(Time dt);
+  /**
+   * Logs how far the node is from the eNB.
+   * \param enbPos set to where the eNB is
+   * \return whether the node is within Range, so what is sent arrives
+   */
+  bool IsCovered(Vector &enbPos) const;
+  PositionBatchFormat GetFormat(const Vector &enbPos) const;
+  /**
+   * Encodes fixes[0, count), given oldest first, into m_payload.
+   */
+  void EncodeBatch(const PositionSample *fixes, uint32_t count, const Vector &enbPos);
+  /**
+   * Asks the batch policy whether nFixes fixes should go now. encode() is
+   * called to fill m_payload before asking only if the policy looks at the
+   * sizes, and otherwise only once it said yes, so a tick that sends
+   * nothing encodes nothing.
+   * \return whether to send; m_payload then holds the encoded batch
+   */
+  template <typename Encode>
+  bool EncodeIfDue(uint32_t nFixes, Encode encode);
+  /**
+   * Sends fixes[0, count), already encoded in m_payload, in as many packets
+   * as MaxPacketSize calls for.
+   */
+  void TransmitBatch(const PositionSample *fixes, uint32_t count, const Vector &enbPos, bool covered);
+
+  NS_LOG_TEMPLATE_DECLARE;
+
+  Ptr<Node> m_node;
+  Ptr<Node> m_enbNode;
+  uint32_t m_vehicleId;
+  uint32_t m_nextId;
+  double m_range;
+
+  Time m_interval;
+  Time m_positionInterval;
+  Ptr<AdaptiveSampler> m_sampler;
+  uint32_t m_extraPayloadSize;
+  std::vector<uint8_t> m_payload;
+  uint32_t m_amountPositionsToSend;
+  Ptr<BatchPolicy> m_batchPolicy;
+  bool m_binaryBatches;
+  bool m_eventDrivenCoverage;
+  uint32_t m_maxPacketSize;
+  PositionPacker m_packer;
+
+  uint32_t m_sent;
+  uint32_t m_lost;
+  Ptr<Socket> m_socket;
+  Address m_peerAddress;
+  uint16_t m_peerPort;
+  EventId m_sendEvent;
+  EventId m_gatherEvent;
+  EventId m_insideEvent;
+  CoverageTracker m_coverage;
+
+  TracedCallback<Ptr<const Packet>> m_txTrace;
+  TracedCallback<Ptr<const Packet>> m_rxTrace;
+  TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_txTraceWithAddresses;
+  TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_rxTraceWithAddresses;
+
+private:
+  virtual void StartApplication(void);
+  virtual void StopApplication(void);
+
+  void ScheduleInside(Time dt);
+  void SchedulePositionGathering(Time dt);
+  void Inside(void);
+  void CoverageChanged(bool inside);
+  void GatherPosition(void);
+  void Transmit(const PositionSample &newest, uint32_t count, bool covered);
+};
+
+template <typename Client, typename Codec>
+TypeId PositionClient<Client, Codec>::AddAttributes(TypeId tid) {
+  return tid
+    .AddAttribute("Interval", 
+                   "The time to wait between packets",
+                   TimeValue(Seconds(1.0)),
+                   MakeTimeAccessor(&PositionClient::m_interval),
+                   MakeTimeChecker())
+    .AddAttribute("PositionInterval", 
+                   "The time to wait between gathering position",
+                   TimeValue(Seconds(1.0)),
+                   MakeTimeAccessor(&PositionClient::m_positionInterval),
+                   MakeTimeChecker())
+    .AddAttribute("AdaptiveSampler", 
+                   "Spaces position gathering by speed and heading instead of every PositionInterval",
+                   PointerValue(nullptr),
+                   MakePointerAccessor(&PositionClient::m_sampler),
+                   MakePointerChecker<AdaptiveSampler>())
+    .AddAttribute("Node", 
+                   "The node in which the application is installed",
+                   PointerValue(nullptr),
+                   MakePointerAccessor(&PositionClient::m_node),
+                   MakePointerChecker<Node>())
+    .AddAttribute("VehicleId", 
+                   "Id the client reports itself as, such as the trace vehicle it plays; the node id by default",
+                   UintegerValue(UINT32_MAX),
+                   MakeUintegerAccessor(&PositionClient::m_vehicleId),
+                   MakeUintegerChecker<uint32_t>())
+    .AddAttribute("ExtraPayloadSize", 
+                   "Extra payload size to add to packets",
+                   UintegerValue(0),
+                   MakeUintegerAccessor(&PositionClient::m_extraPayloadSize),
+                   MakeUintegerChecker<uint32_t>())
+    .AddAttribute("AmountPositionsToSend", 
+                   "Amount of positions to send each time",
+                   UintegerValue(10),
+                   MakeUintegerAccessor(&PositionClient::m_amountPositionsToSend),
+                   MakeUintegerChecker<uint32_t>())
+    .AddAttribute("BatchPolicy", 
+                   "Decides when gathered positions are sent; by default, once AmountPositionsToSend are gathered",
+                   PointerValue(nullptr),
+                   MakePointerAccessor(&PositionClient::m_batchPolicy),
+                   MakePointerChecker<BatchPolicy>())
+    .AddAttribute("BinaryBatches", 
+                   "Send batches in the compact binary encoding instead of text",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&PositionClient::m_binaryBatches),
+                   MakeBooleanChecker())
+    .AddAttribute("EventDrivenCoverage", 
+                   "Log coverage changes when the node crosses the range instead of checking every second",
+                   BooleanValue(false),
+                   MakeBooleanAccessor(&PositionClient::m_eventDrivenCoverage),
+                   MakeBooleanChecker())
+    .AddAttribute("MaxPacketSize", 
+                   "Bytes a packet may take, padding included, such as what fits an EDT transport block; larger batches are split over several packets (0 for no limit)",
+                   UintegerValue(0),
+                   MakeUintegerAccessor(&PositionClient::m_maxPacketSize),
+                   MakeUintegerChecker<uint32_t>())
+    .AddAttribute("EnbNode", 
+                   "The enbNode to which the node is attached to",
+                   PointerValue(nullptr),
+                   MakePointerAccessor(&PositionClient::m_enbNode),
+                   MakePointerChecker<Node>())
+    .AddAttribute("Range", 
+                   "The enbNode range",
+                   DoubleValue(0.0),
+                   MakeDoubleAccessor(&PositionClient::m_range),
+                   MakeDoubleChecker<double>())
+    .AddAttribute("RemoteAddress", 
+                   "The destination Address of the outbound packets",
+                   AddressValue(),
+                   MakeAddressAccessor(&PositionClient::m_peerAddress),
+                   MakeAddressChecker())
+    .AddAttribute("RemotePort", 
+                   "The destination port of the outbound packets",
+                   UintegerValue(0),
+                   MakeUintegerAccessor(&PositionClient::m_peerPort),
+                   MakeUintegerChecker<uint16_t>())
+    .AddTraceSource("Tx", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor(&PositionClient::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource("Rx", "A packet has been received",
+                     MakeTraceSourceAccessor(&PositionClient::m_rxTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource("TxWithAddresses", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor(&PositionClient::m_txTraceWithAddresses),
+                     "ns3::Packet::TwoAddressTracedCallback")
+    .AddTraceSource("RxWithAddresses", "A packet has been received",
+                     MakeTraceSourceAccessor(&PositionClient::m_rxTraceWithAddresses),
+                     "ns3::Packet::TwoAddressTracedCallback")
+  ;
+}
+
+template <typename Client, typename Codec>
+PositionClient<Client, Codec>::PositionClient(const std::string &logComponent)
+  : NS_LOG_TEMPLATE_DEFINE(logComponent) {
+  NS_LOG_FUNCTION(this);
+  m_sent = 0;
+  m_lost = 0;
+  m_socket = 0;
+  m_node = nullptr;
+  m_enbNode = nullptr;
+  m_vehicleId = UINT32_MAX;
+  m_nextId = 0;
+  m_range = 0;
+  m_extraPayloadSize = 0;
+  m_amountPositionsToSend = 10;
+  m_binaryBatches = false;
+  m_eventDrivenCoverage = false;
+  m_maxPacketSize = 0;
+  m_peerPort = 0;
+  m_sendEvent = EventId();
+  m_gatherEvent = EventId();
+  m_insideEvent = EventId();
+}
+
+template <typename Client, typename Codec>
+PositionClient<Client, Codec>::~PositionClient() {
+  NS_LOG_FUNCTION(this);
+  m_socket = 0;
+  m_node = nullptr;
+  m_enbNode = nullptr;
+}
+
+template <typename Client, typename Codec>
+void PositionClient<Client, Codec>::DoDispose(void) {
+  NS_LOG_FUNCTION(this);
+  m_batchPolicy = 0;
+  m_sampler = 0;
+  Application::DoDispose();
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::StartApplication(void) {
+  NS_LOG_FUNCTION(this);
+
+  if (m_batchPolicy == 0) {
+    m_batchPolicy = CreateObject<CountBatchPolicy>();
+    m_batchPolicy->SetAttribute("Count", UintegerValue(m_amountPositionsToSend));
+  }
+  if (m_vehicleId == UINT32_MAX) {
+    m_vehicleId = m_node->GetId();
+  }
+  if (!m_packer.SetLimit(m_maxPacketSize, m_extraPayloadSize) && m_maxPacketSize > 0) {
+    NS_LOG_WARN("padding of " << m_extraPayloadSize << " bytes leaves no room in packets of "
+                << m_maxPacketSize << " bytes, so batches are not split");
+  }
+
+  if (m_socket == 0) {
+    TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+    m_socket = Socket::CreateSocket(GetNode(), tid);
+    if (Ipv4Address::IsMatchingType(m_peerAddress) == true) {
+      if (m_socket->Bind() == -1) {
+        NS_FATAL_ERROR("Failed to bind socket");
+      }
+
+      m_socket->Connect(InetSocketAddress(Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
+    } else if (Ipv6Address::IsMatchingType(m_peerAddress) == true) {
+      if (m_socket->Bind6() == -1) {
+        NS_FATAL_ERROR("Failed to bind socket");
+      }
+
+      m_socket->Connect(Inet6SocketAddress(Ipv6Address::ConvertFrom(m_peerAddress), m_peerPort));
+    } else if (InetSocketAddress::IsMatchingType(m_peerAddress) == true) {
+      if (m_socket->Bind() == -1) {
+        NS_FATAL_ERROR("Failed to bind socket");
+      }
+
+      m_socket->Connect(m_peerAddress);
+    } else if (Inet6SocketAddress::IsMatchingType(m_peerAddress) == true) {
+      if (m_socket->Bind6() == -1) {
+        NS_FATAL_ERROR("Failed to bind socket");
+      }
+
+      m_socket->Connect(m_peerAddress);
+    } else {
+      NS_ASSERT_MSG(false, "Incompatible address type: " << m_peerAddress);
+    }
+  }
+
+  m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+  m_socket->SetAllowBroadcast(false);
+  Self().OnStart();
+  if (Self().SendsOnTimer()) {
+    ScheduleTransmit(Seconds(0.));
+  }
+  if (m_sampler != 0) {
+    m_sampler->Start(m_node->GetObject<MobilityModel>(), MakeCallback(&PositionClient::GatherPosition, this));
+  } else {
+    SchedulePositionGathering(Seconds(0.));
+  }
+  if (m_eventDrivenCoverage || Self().TracksCoverage()) {
+    m_coverage.Start(m_node->GetObject<MobilityModel>(), m_enbNode->GetObject<MobilityModel>(), m_range,
+                     MakeCallback(&PositionClient::CoverageChanged, this));
+  }
+  if (!m_eventDrivenCoverage) {
+    ScheduleInside(Seconds(0.));
+  }
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::StopApplication() {
+  NS_LOG_FUNCTION(this);
+
+  if (m_socket != 0)  {
+    m_socket->Close();
+    m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    m_socket = 0;
+  }
+
+  Simulator::Cancel(m_sendEvent);
+  Simulator::Cancel(m_gatherEvent);
+  if (m_sampler != 0) {
+    m_sampler->Stop();
+  }
+  Simulator::Cancel(m_insideEvent);
+  m_coverage.Stop();
+  if (m_batchPolicy != 0) {
+    m_batchPolicy->Clear();
+  }
+  NS_LOG_INFO("took " << m_nextId << " fixes");
+  Self().OnStop();
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::ScheduleInside(Time dt) {
+  NS_LOG_FUNCTION(this << dt);
+  m_insideEvent = Simulator::Schedule(dt, &PositionClient::Inside, this);
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::ScheduleTransmit(Time dt) {
+  NS_LOG_FUNCTION(this << dt);
+  m_sendEvent = Simulator::Schedule(dt, &Client::Send, &Self());
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::SchedulePositionGathering(Time dt) {
+  NS_LOG_FUNCTION(this << dt);
+  m_gatherEvent = Simulator::Schedule(dt, &PositionClient::GatherPosition, this);
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::Inside(void) {
+  NS_LOG_FUNCTION(this);
+
+  Ptr<MobilityModel> ueMobility = m_node->GetObject<MobilityModel>();
+  Ptr<MobilityModel> enbMobility = m_enbNode->GetObject<MobilityModel>();
+
+  Vector uePos = ueMobility->GetPosition();
+  Vector enbPos = enbMobility->GetPosition();
+  double distance = CalculateDistance(uePos, enbPos);
+
+  if (m_range <= distance) {
+    NS_LOG_INFO("inside");
+  } else {
+    NS_LOG_INFO("outside");
+  }
+
+  m_insideEvent = Simulator::Schedule(Seconds(1.0), &PositionClient::Inside, this);
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::CoverageChanged(bool inside) {
+  NS_LOG_FUNCTION(this << inside);
+
+  if (m_eventDrivenCoverage) {
+    if (inside) {
+      NS_LOG_INFO("inside");
+    } else {
+      NS_LOG_INFO("outside");
+    }
+  }
+
+  Self().OnCoverageChanged(inside);
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::GatherPosition(void) {
+  NS_LOG_FUNCTION(this);
+
+  Ptr<MobilityModel> ueMobility = m_node->GetObject<MobilityModel>();
+  Vector uePos = ueMobility->GetPosition();
+
+  PositionSample sample;
+  sample.id = m_nextId++;
+  sample.timestamp = Simulator::Now().GetTimeStep();
+  sample.x = uePos.x;
+  sample.y = uePos.y;
+  sample.z = uePos.z;
+  sample.speed = 0;
+  if (Codec::kSpeed) {
+    Vector ueVel = ueMobility->GetVelocity();
+    sample.speed = std::sqrt(ueVel.x*ueVel.x + ueVel.y*ueVel.y);
+  }
+  m_batchPolicy->Add(sample);
+  NS_LOG_INFO("consumed 33 mJ");
+  Self().Keep(sample);
+
+  if (m_sampler == 0) {
+    m_gatherEvent = Simulator::Schedule(m_positionInterval, &PositionClient::GatherPosition, this);
+  }
+}
+
+template <typename Client, typename Codec>
+bool  PositionClient<Client, Codec>::IsCovered(Vector &enbPos) const {
+  Vector uePos = m_node->GetObject<MobilityModel>()->GetPosition();
+  enbPos = m_enbNode->GetObject<MobilityModel>()->GetPosition();
+  double distance = CalculateDistance(uePos, enbPos);
+
+  NS_LOG_INFO("is " << distance << "m from eNB");
+  return m_range <= distance;
+}
+
+template <typename Client, typename Codec>
+PositionBatchFormat  PositionClient<Client, Codec>::GetFormat(const Vector &enbPos) const {
+  return Codec::GetFormat(m_binaryBatches, m_vehicleId, enbPos);
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::EncodeBatch(const PositionSample *fixes, uint32_t count, const Vector &enbPos) {
+  NS_LOG_FUNCTION(this << count);
+
+  // The batch is encoded into a buffer kept across sends, which also takes
+  // the padding when the packet is built, so neither is allocated per send.
+  m_payload.clear();
+  Codec::Encode(m_payload, fixes, count, GetFormat(enbPos));
+}
+
+template <typename Client, typename Codec>
+template <typename Encode>
+bool  PositionClient<Client, Codec>::EncodeIfDue(uint32_t nFixes, Encode encode) {
+  if (!m_batchPolicy->NeedsSizes()) {
+    if (!m_batchPolicy->ShouldSend(Simulator::Now(), nFixes, 0, 0)) {
+      return false;
+    }
+    encode();
+    return true;
+  }
+
+  encode();
+  uint32_t size = m_payload.size();
+  return m_batchPolicy->ShouldSend(Simulator::Now(), nFixes, size, size + m_extraPayloadSize);
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::TransmitBatch(const PositionSample *fixes, uint32_t count, const Vector &enbPos,
+                                                   bool covered) {
+  NS_LOG_FUNCTION(this << count << covered);
+  NS_ASSERT(count > 0);
+
+  if (m_packer.Fits(m_payload.size())) {
+    Transmit(fixes[count - 1], count, covered);
+    return;
+  }
+
+  // Oldest fixes first, as when held positions are flushed.
+  PositionBatchFormat format = GetFormat(enbPos);
+  const std::vector<uint32_t> &runs = m_packer.Split(fixes, count, format);
+  NS_LOG_INFO("splitting " << count << " positions over " << runs.size() << " packets");
+  for (uint32_t run : runs) {
+    m_payload.clear();
+    Codec::Encode(m_payload, fixes, run, format);
+    Transmit(fixes[run - 1], run, covered);
+    fixes += run;
+  }
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::Transmit(const PositionSample &newest, uint32_t count, bool covered) {
+  NS_LOG_FUNCTION(this << count << covered);
+
+  Self().OnTransmit(newest);
+
+  Address localAddress;
+  m_socket->GetSockName(localAddress);
+
+  Ptr<Packet> p = CreatePositionPacket(m_payload, m_extraPayloadSize);
+
+  m_txTrace(p);
+
+  if (Ipv4Address::IsMatchingType(m_peerAddress)) {
+    m_txTraceWithAddresses(p, localAddress, InetSocketAddress(Ipv4Address::ConvertFrom(m_peerAddress), m_peerPort));
+  } else if (Ipv6Address::IsMatchingType(m_peerAddress)) {
+    m_txTraceWithAddresses(p, localAddress, Inet6SocketAddress(Ipv6Address::ConvertFrom(m_peerAddress), m_peerPort));
+  }
+
+  if (!covered) {
+    Self().OnLost(count);
+    ++m_lost;
+    ++m_sent;
+    return;
+  }
+
+  m_socket->Send(p);
+  ++m_sent;
+
+  if (Ipv4Address::IsMatchingType(m_peerAddress)) {
+    NS_LOG_INFO("sent '" << DescribePositionPayload(m_payload, m_extraPayloadSize) << "' to " << Ipv4Address::ConvertFrom(m_peerAddress)
+                << " port " << m_peerPort);
+  } else if (Ipv6Address::IsMatchingType(m_peerAddress)) {
+    NS_LOG_INFO("sent '" << DescribePositionPayload(m_payload, m_extraPayloadSize) << "' to " << Ipv6Address::ConvertFrom(m_peerAddress)
+                << " port " << m_peerPort);
+  } else if (InetSocketAddress::IsMatchingType(m_peerAddress)) {
+    NS_LOG_INFO("sent '" << DescribePositionPayload(m_payload, m_extraPayloadSize) << "' to " << InetSocketAddress::ConvertFrom(m_peerAddress).GetIpv4()
+                << " port " << InetSocketAddress::ConvertFrom(m_peerAddress).GetPort());
+  } else if (Inet6SocketAddress::IsMatchingType(m_peerAddress)) {
+    NS_LOG_INFO("sent '" << DescribePositionPayload(m_payload, m_extraPayloadSize) << "' to " << Inet6SocketAddress::ConvertFrom(m_peerAddress).GetIpv6()
+                << " port " << Inet6SocketAddress::ConvertFrom(m_peerAddress).GetPort());
+  }
+}
+
+template <typename Client, typename Codec>
+void  PositionClient<Client, Codec>::OnLost(uint32_t count) const {
+  NS_LOG_INFO("Package lost");
+}
+
+} // namespace ns3
+
+#endif /* POSITION_CLIENT_H */
@@ -0,0 +1,84 @@
+#include "position-packer.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+namespace {
+
+// Headers in an EDT transport block besides the datagram's payload: IPv4
+// (20) and UDP (8), then PDCP (2) and RLC (2) as ns-3's LTE stack writes
+// them.
+const uint32_t kEdtHeaderBytes = 20 + 8 + 2 + 2;
+
+uint32_t VarintSize(uint64_t value) {
+  uint32_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+} // namespace
+
+uint32_t GetEdtMaxPacketSize(uint32_t tbsBits) {
+  uint32_t block = tbsBits / 8;
+  return block > kEdtHeaderBytes ? block - kEdtHeaderBytes : 0;
+}
+
+PositionPacker::PositionPacker()
+  : m_budget(0) {
+}
+
+bool PositionPacker::SetLimit(uint32_t maxPacketSize, uint32_t padding) {
+  m_budget = maxPacketSize > padding ? maxPacketSize - padding : 0;
+  return m_budget > 0;
+}
+
+const std::vector<uint32_t> &PositionPacker::Split(const PositionSample *fixes, uint32_t count,
+                                                   const PositionBatchFormat &format) {
+  m_runs.clear();
+  if (m_budget == 0) {
+    if (count > 0) {
+      m_runs.push_back(count);
+    }
+    return m_runs;
+  }
+
+  bool withSpeed = format.header.flags & kPositionBatchSpeed;
+  PositionBatchHeader header = format.header;
+  header.count = 0;
+
+  // Fixes [0, end) are left; each pass takes a run off their newest end.
+  uint32_t end = count;
+  while (end > 0) {
+    m_scratch.clear();
+    uint32_t run = 0;
+    if (format.binary) {
+      PositionBatchEncoder encoder(m_scratch, header, format.origin);
+      while (run < end) {
+        encoder.Add(fixes[end - 1 - run]);
+        // The header went in with a count of 0, which takes one byte.
+        if (run > 0 && m_scratch.size() - 1 + VarintSize(run + 1) > m_budget) {
+          break;
+        }
+        ++run;
+      }
+    } else {
+      while (run < end) {
+        AppendPositionSample(m_scratch, fixes[end - 1 - run], withSpeed);
+        if (run > 0 && format.textOverhead + m_scratch.size() > m_budget) {
+          break;
+        }
+        ++run;
+      }
+    }
+    m_runs.push_back(run);
+    end -= run;
+  }
+  std::reverse(m_runs.begin(), m_runs.end());
+  return m_runs;
+}
+
+} // namespace ns3
@@ -0,0 +1,80 @@
+#ifndef POSITION_PACKER_H
+#define POSITION_PACKER_H
+
+#include "ns3/vector.h"
+#include "position-batch-codec.h"
+#include "position-sample.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Largest transport block NB-IoT lets a UE fill with early data
+ * transmission (EDT), in bits: the top edt-TBS of TS 36.331.
+ */
+const uint32_t kEdtMaxTbsBits = 1000;
+
+/**
+ * \param tbsBits EDT transport block size configured for the cell
+ * \return the largest UDP payload, in bytes, that still goes out in an EDT
+ * transport block of that size, next to the IPv4, UDP, PDCP and RLC
+ * headers ns-3's LTE stack adds to it; 0 if not even the headers fit
+ */
+uint32_t GetEdtMaxPacketSize(uint32_t tbsBits);
+
+/**
+ * How a client writes its batches.
+ */
+struct PositionBatchFormat {
+  bool binary;
+  PositionBatchHeader header;  // flags and node id; the count is ignored
+  Vector origin;               // of the cell, for binary batches
+  uint32_t textOverhead;       // bytes a text batch adds around its fixes
+};
+
+/**
+ * Splits batches that would not fit a packet of bounded size, padding
+ * included, into runs of fixes that do, so each goes in one packet.
+ *
+ * Batches list fixes newest first, and in binary each fix is encoded
+ * against the ones before it, so runs are filled greedily from the newest
+ * fix with the real encoding: every packet but the one with the oldest
+ * fixes ends up just under the limit.
+ */
+class PositionPacker {
+public:
+  PositionPacker();
+
+  /**
+   * \param maxPacketSize bytes a packet may take, 0 for no limit
+   * \param padding bytes each packet carries after its batch
+   * \return whether anything is left for the batch; if not, there is no
+   * limit, since no packet would fit anyway
+   */
+  bool SetLimit(uint32_t maxPacketSize, uint32_t padding);
+
+  /**
+   * \return whether a batch of batchSize bytes fits in one packet
+   */
+  bool Fits(uint32_t batchSize) const { return m_budget == 0 || batchSize <= m_budget; }
+
+  /**
+   * \param fixes to send, oldest first
+   * \param count of fixes
+   * \param format the fixes are written in
+   * \return the number of fixes in each run, oldest run first; a fix too
+   * big on its own still gets a run
+   */
+  const std::vector<uint32_t> &Split(const PositionSample *fixes, uint32_t count, const PositionBatchFormat &format);
+
+private:
+  uint32_t m_budget;  // bytes of batch per packet, 0 for no limit
+  std::vector<uint32_t> m_runs;
+  std::vector<uint8_t> m_scratch;
+};
+
+} // namespace ns3
+
+#endif /* POSITION_PACKER_H */
@@ -0,0 +1,41 @@
+#include "position-packet.h"
+#include "position-batch-codec.h"
+
+#include <algorithm>
+#include <string>
+
+namespace ns3 {
+
+Ptr<Packet> CreatePositionPacket(std::vector<uint8_t> &payload, uint32_t padding) {
+  // Once the buffer has grown to the largest batch plus padding, neither is
+  // allocated again; the packet copies both at once.
+  size_t size = payload.size();
+  payload.resize(size + padding, '.');
+  Ptr<Packet> packet = Create<Packet>(payload.data(), payload.size());
+  payload.resize(size);
+  return packet;
+}
+
+PositionPayloadDescription DescribePositionPayload(const std::vector<uint8_t> &payload, uint32_t padding) {
+  PositionPayloadDescription description = {&payload, padding};
+  return description;
+}
+
+std::ostream &operator<<(std::ostream &os, const PositionPayloadDescription &description) {
+  const std::vector<uint8_t> &payload = *description.payload;
+  if (PositionBatchDecoder::IsBinaryBatch(payload.data(), payload.size())) {
+    return os << "<" << payload.size() << " byte batch>";
+  }
+  os.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+  // The padding goes out in blocks of dots rather than through setw, which
+  // pads one character at a time.
+  static const std::string dots(256, '.');
+  for (uint32_t left = description.padding; left > 0;) {
+    uint32_t n = std::min<uint32_t>(left, dots.size());
+    os.write(dots.data(), n);
+    left -= n;
+  }
+  return os;
+}
+
+} // namespace ns3
@@ -0,0 +1,41 @@
+#ifndef POSITION_PACKET_H
+#define POSITION_PACKET_H
+
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \param payload encoded batch; the padding is appended to it for the copy
+ * into the packet and taken off again, so the buffer is reused across sends
+ * \param padding number of '.' bytes after the batch
+ * \return the packet to send
+ */
+Ptr<Packet> CreatePositionPacket(std::vector<uint8_t> &payload, uint32_t padding);
+
+/**
+ * A batch as the clients log it, written straight into the log stream so
+ * that neither the batch nor the padding is copied into a string.
+ */
+struct PositionPayloadDescription {
+  const std::vector<uint8_t> *payload;
+  uint32_t padding;
+};
+
+/**
+ * \param payload encoded batch
+ * \param padding number of '.' bytes sent after the batch
+ * \return what prints a text batch as it is sent, a binary one as its size
+ */
+PositionPayloadDescription DescribePositionPayload(const std::vector<uint8_t> &payload, uint32_t padding);
+
+std::ostream &operator<<(std::ostream &os, const PositionPayloadDescription &description);
+
+} // namespace ns3
+
+#endif /* POSITION_PACKET_H */
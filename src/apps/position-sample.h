@@ -0,0 +1,43 @@
+#ifndef POSITION_SAMPLE_H
+#define POSITION_SAMPLE_H
+
+#include <cstdio>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * One GPS fix taken by a position client. It is plain data, so the fixes
+ * waiting to be sent sit in one contiguous array and taking a fix never
+ * allocates; they are only formatted when a batch is written to the wire.
+ */
+struct PositionSample {
+  int64_t timestamp; // Time::GetTimeStep() when the fix was taken
+  double x;
+  double y;
+  double z;
+  double speed;      // m/s
+  uint32_t id;       // sequence number of the fix within its client
+};
+
+/**
+ * Appends a fix the way the clients put it in a text batch:
+ * "<id> <x>,<y>,<z>\n", with ";<speed>" before the newline when withSpeed
+ * is set. Numbers are printed as an std::ostream would by default.
+ */
+inline void AppendPositionSample(std::vector<uint8_t> &out, const PositionSample &sample, bool withSpeed) {
+  char line[128];
+  int size;
+  if (withSpeed) {
+    size = std::snprintf(line, sizeof(line), "%u %g,%g,%g;%g\n", sample.id, sample.x, sample.y, sample.z,
+                         sample.speed);
+  } else {
+    size = std::snprintf(line, sizeof(line), "%u %g,%g,%g\n", sample.id, sample.x, sample.y, sample.z);
+  }
+  out.insert(out.end(), line, line + size);
+}
+
+} // namespace ns3
+
+#endif /* POSITION_SAMPLE_H */
@@ -11,8 +11,14 @@
 #include "ns3/socket-factory.h"
 #include "ns3/packet.h"
 #include "ns3/uinteger.h"
+#include "ns3/vector.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/ipv4.h"
 #include "simple-position-server.h"
+#include "position-batch-codec.h"
 
+#include <cstdio>
 #include <sstream>
 #include <iostream>
 
@@ -31,6 +37,10 @@ TypeId SimplePositionServer::GetTypeId(void) {
                    UintegerValue(9),
                    MakeUintegerAccessor(&SimplePositionServer::m_port),
                    MakeUintegerChecker<uint16_t>())
+    .AddAttribute("CellOrigin", "Origin the clients encode binary batches against (the eNB position).",
+                   VectorValue(Vector(0, 0, 0)),
+                   MakeVectorAccessor(&SimplePositionServer::m_cellOrigin),
+                   MakeVectorChecker())
     .AddTraceSource("Rx", "A packet has been received",
                      MakeTraceSourceAccessor(&SimplePositionServer::m_rxTrace),
                      "ns3::Packet::TracedCallback")
@@ -51,6 +61,37 @@ SimplePositionServer::~SimplePositionServer() {
   m_socket6 = 0;
 }
 
+bool SimplePositionServer::GetEstimatedPosition(uint32_t nodeId, Vector &position, Time &received) const {
+  auto it = m_lastPositions.find(nodeId);
+  if (it == m_lastPositions.end()) {
+    return false;
+  }
+  position = it->second.position;
+  received = it->second.received;
+  return true;
+}
+
+uint32_t SimplePositionServer::GetSenderNode(const Address &from) {
+  // Clients do not name themselves in their batches, so the node is found
+  // once from the source address and remembered.
+  Ipv4Address address = InetSocketAddress::ConvertFrom(from).GetIpv4();
+  auto it = m_senderNodes.find(address);
+  if (it != m_senderNodes.end()) {
+    return it->second;
+  }
+
+  uint32_t nodeId = UINT32_MAX;
+  for (NodeList::Iterator node = NodeList::Begin(); node != NodeList::End(); ++node) {
+    Ptr<Ipv4> ipv4 = (*node)->GetObject<Ipv4>();
+    if (ipv4 != 0 && ipv4->GetInterfaceForAddress(address) >= 0) {
+      nodeId = (*node)->GetId();
+      break;
+    }
+  }
+  m_senderNodes[address] = nodeId;
+  return nodeId;
+}
+
 void SimplePositionServer::DoDispose(void) {
   NS_LOG_FUNCTION(this);
   Application::DoDispose();
@@ -139,6 +180,11 @@ void  SimplePositionServer::HandleRead(Ptr<Socket> socket) {
     packet->CopyData(msgRaw, size);
     msgRaw[size] = '\0';
     std::string msg = reinterpret_cast<char*>(msgRaw);
+    // Binary batches are logged by size.
+    bool binary = PositionBatchDecoder::IsBinaryBatch(msgRaw, size);
+    if (binary) {
+      msg = "<" + std::to_string(size) + " byte batch>";
+    }
 
     if (InetSocketAddress::IsMatchingType(from)) {
       NS_LOG_INFO("At time " << Simulator::Now().As(Time::S) << " server received '" << msg << "' from " <<
@@ -150,6 +196,21 @@ void  SimplePositionServer::HandleRead(Ptr<Socket> socket) {
                    Inet6SocketAddress::ConvertFrom(from).GetPort());
     }
 
+    // Batches list the newest position first, in text as "<id> <x>,<y>,<z>".
+    PositionSample newest;
+    bool parsed;
+    if (binary) {
+      PositionBatchDecoder decoder(msgRaw, size, m_cellOrigin);
+      PositionBatchHeader header;
+      parsed = decoder.ReadHeader(header) && decoder.Next(newest);
+    } else {
+      parsed = std::sscanf(msg.c_str(), "%u %lf,%lf,%lf", &newest.id, &newest.x, &newest.y, &newest.z) == 4;
+    }
+    if (parsed && InetSocketAddress::IsMatchingType(from)) {
+      LastReport report = {Vector(newest.x, newest.y, newest.z), Simulator::Now()};
+      m_lastPositions[GetSenderNode(from)] = report;
+    }
+
     // std::istringstream batch(msg);
     // std::string line;
 
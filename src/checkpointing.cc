@@ -1,9 +1,13 @@
 #include "ns3/core-module.h"
+#include "ns3/network-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/checkpointing-position-client.h"
 #include "ns3/checkpointing-position-server.h"
+#include "ns3/adaptive-sampler.h"
+#include "ns3/batch-policy.h"
+#include "ns3/position-packer.h"
 #include "ns3/mobility-module.h"
 #include "ns3/config-store-module.h"
 #include "ns3/random-variable-stream.h"
@@ -21,6 +25,10 @@ using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("TCC");
 
+static void IntervalChanged(Ptr<OutputStreamWrapper> stream, std::string context, Time oldValue, Time newValue) {
+  *stream->GetStream() << Simulator::Now().GetSeconds() << "\t" << context << "\t" << newValue.GetSeconds() << std::endl;
+}
+
 int main(int argc, char *argv[]) {
   LogComponentEnableAll(LOG_PREFIX_TIME);
   LogComponentEnableAll(LOG_PREFIX_NODE);
@@ -34,14 +42,33 @@ int main(int argc, char *argv[]) {
   std::string simName = "test";
   double cellsize = 1000;
   int packetsize_app_a = 49; // 32 Bytes 5G mMTC payload + 4 Bytes CoAP Header + 13 Bytes DTLS Header
-  int payloadSize;
-  double syncFrequency;
+  int payloadSize = 0;
+  double syncFrequency = 1.0;
   double positionInterval = 1.0;
   double range = 300.0; // in meters
   bool edt = false;
+  uint32_t edtTbs = kEdtMaxTbsBits;
+  bool streamingMobility = false;
+  uint32_t parseThreads = 1;
+  bool recycleNodes = false;
+  double waypointTolerance = 0;
+  bool traceCache = false;
+  bool evaluateAccuracy = false;
+  double accuracyInterval = 1.0;
+  bool binaryBatches = false;
+  bool eventCoverage = false;
+  std::string batchPolicy = "count";
+  bool adaptiveSampling = false;
+  bool windowedRetransmission = false;
+  uint32_t maxBacklog = 0;
+  uint32_t maxBacklogBytes = 0;
+  double backlogTolerance = 0;
+  bool adaptiveInterval = false;
+  double minInterval = 0;
+  double maxInterval = 600;
 
   CommandLine cmd(__FILE__);
-  cmd.AddValue("mobilityFile", "Mobility file", mobilityFile);
+  cmd.AddValue("mobilityFile", "Mobility file (ns-2 script, SUMO FCD output or compiled trace)", mobilityFile);
   cmd.AddValue("range", "enB tower range", range);
   cmd.AddValue("simName", "Total duration of the simulation", simName);
   cmd.AddValue("payloadSize", "Size of the payload", payloadSize);
@@ -50,20 +77,83 @@ int main(int argc, char *argv[]) {
   cmd.AddValue("worker", "worker id when using multithreading to not confuse logging", worker);
   cmd.AddValue("randomSeed", "randomSeed", seed);
   cmd.AddValue("edt", "Early Data Transmission", edt);
+  cmd.AddValue("edtTbs", "EDT transport block size of the cell in bits; with --edt, batches are split into packets that fit it", edtTbs);
+  cmd.AddValue("streamingMobility", "Read trace waypoints in chunks while the simulation runs", streamingMobility);
+  cmd.AddValue("parseThreads", "Threads used to parse a textual mobility trace", parseThreads);
+  cmd.AddValue("recycleNodes", "Let vehicles that are never present at the same time share a node", recycleNodes);
+  cmd.AddValue("traceCache", "Keep the parsed trace in a sidecar file next to it for later runs", traceCache);
+  cmd.AddValue("waypointTolerance", "Merge trace waypoints as long as positions stay within this distance in meters (0 keeps them all)", waypointTolerance);
+  cmd.AddValue("evaluateAccuracy", "Compare the server's view of the vehicles with their trace positions", evaluateAccuracy);
+  cmd.AddValue("accuracyInterval", "Time between tracking accuracy samples", accuracyInterval);
+  cmd.AddValue("binaryBatches", "Send position batches in the compact binary encoding", binaryBatches);
+  cmd.AddValue("eventCoverage", "Log coverage only when a vehicle crosses the range instead of every second", eventCoverage);
+  cmd.AddValue("batchPolicy", "When clients send what they gathered: count, fresh, age, bytes, distance or heading (tune them with --ns3::AgeBatchPolicy::MaxAge=... and the like)", batchPolicy);
+  cmd.AddValue("adaptiveSampling", "Space position gathering by speed and heading instead of every syncFrequency (tune it with --ns3::AdaptiveSampler::MaxInterval=... and the like)", adaptiveSampling);
+  cmd.AddValue("windowedRetransmission", "Send each position once and resend it only on timeout or when the server skips it (tune it with --ns3::CheckpointingPositionClient::MaxRto=... and the like)", windowedRetransmission);
+  cmd.AddValue("maxBacklog", "Most unacknowledged positions a client keeps, evicting those that least change the route (0 keeps them all)", maxBacklog);
+  cmd.AddValue("maxBacklogBytes", "Most bytes of unacknowledged positions a client keeps, as text (0 for no bound)", maxBacklogBytes);
+  cmd.AddValue("adaptiveInterval", "Lengthen the time between packets while acks come late or not at all (tune it with --ns3::CheckpointingPositionClient::IntervalStep=... and the like)", adaptiveInterval);
+  cmd.AddValue("minInterval", "Shortest time between packets with adaptiveInterval (0 for positionInterval)", minInterval);
+  cmd.AddValue("maxInterval", "Longest time between packets with adaptiveInterval", maxInterval);
+  cmd.AddValue("backlogTolerance", "Meters an unacknowledged position may stray from the route and still be evicted within the bounds", backlogTolerance);
   cmd.Parse(argc, argv);
 
+  if (CreateBatchPolicy(batchPolicy) == 0) {
+    NS_FATAL_ERROR("Unknown batch policy " << batchPolicy);
+  }
+
+  // With EDT, a packet that outgrows the transport block would need a full
+  // RRC connection, so clients split their batches to stay within it.
+  uint32_t maxPacketSize = 0;
+  if (edt) {
+    maxPacketSize = GetEdtMaxPacketSize(edtTbs);
+    NS_LOG_INFO("EDT packets carry up to " << maxPacketSize << " bytes, padding included");
+  }
+
   ConfigStore inputConfig;
   inputConfig.ConfigureDefaults();
 
-  Ns2NodeUtility ns2Utility(mobilityFile);
+  // Parse the trace once; it provides both the node lifetimes and the mobility.
+  Ptr<Ns2BinaryTrace> mobilityTrace = traceCache ? Ns2BinaryTrace::LoadCached(mobilityFile, parseThreads)
+                                                 : Ns2BinaryTrace::Load(mobilityFile, parseThreads);
+  if (mobilityTrace == 0) {
+    NS_FATAL_ERROR("Could not read mobility file " << mobilityFile);
+  }
+  // The trace as read is the ground truth, even when the simulation uses a simplified one.
+  Ptr<Ns2BinaryTrace> groundTruth = mobilityTrace;
+  if (waypointTolerance > 0) {
+    uint64_t events = mobilityTrace->GetNMobilityEvents();
+    mobilityTrace = Ns2BinaryTrace::Simplify(mobilityTrace, waypointTolerance);
+    NS_LOG_INFO("Waypoint compression: " << events << " -> " << mobilityTrace->GetNMobilityEvents() << " mobility events");
+  }
+  Ns2NodeUtility ns2Utility(mobilityTrace);
 
   uint64_t ues_to_consider = ns2Utility.GetNNodes();
   Time simTime = Seconds(ns2Utility.GetSimulationTime());
 
+  // Vehicles played by each UE node. Without recycling every vehicle gets its
+  // own node; with it, vehicles with disjoint lifetimes take turns on a node,
+  // so only as many nodes as vehicles present at once are created.
+  std::vector<std::vector<uint32_t>> ueVehicles;
+  if (recycleNodes) {
+    uint32_t slots = ns2Utility.AssignSlots();
+    for (uint32_t s = 0; s < slots; s++) {
+      ueVehicles.push_back(ns2Utility.GetNodesInSlot(s));
+    }
+    NS_LOG_INFO("Recycling " << ues_to_consider << " vehicles on " << slots << " nodes");
+  } else {
+    for (uint32_t i = 0; i < ues_to_consider; i++) {
+      ueVehicles.push_back(std::vector<uint32_t>(1, i));
+    }
+  }
+
   NodeContainer ueNodes;
-  ueNodes.Create(ues_to_consider);
-  Ns2MobilityHelper sumoTrace(mobilityFile);
-  sumoTrace.Install();
+  ueNodes.Create(ueVehicles.size());
+  Ns2BinaryMobilityHelper sumoTrace(mobilityTrace);
+  sumoTrace.SetStreaming(streamingMobility);
+  for (uint32_t u = 0; u < ueNodes.GetN(); u++) {
+    sumoTrace.Install(ueNodes.Get(u), ueVehicles[u]);
+  }
 
   Ptr<LteHelper> lteHelper = CreateObject<LteHelper>();
   Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper>();
@@ -139,16 +229,17 @@ int main(int argc, char *argv[]) {
 
   Ptr<CheckpointingPositionServer> serverApp = CreateObject<CheckpointingPositionServer>();
   serverApp->SetAttribute("Port", UintegerValue(ulPort));
+  serverApp->SetAttribute("CellOrigin", VectorValue(enbNodes.Get(0)->GetObject<MobilityModel>()->GetPosition()));
   remoteHost->AddApplication(serverApp);
   serverApp->SetStartTime(MilliSeconds(50));
   serverApp->SetStopTime(simTime);
 
   InetSocketAddress serverAddress(remoteHostAddr, ulPort);
   
-  for (uint16_t i = 0; i < ues_to_consider; i++) {
-    lteHelper->AttachSuspendedNb(ueLteDevs.Get(i), enbLteDevs.Get(0));
+  for (uint32_t u = 0; u < ueNodes.GetN(); u++) {
+    lteHelper->AttachSuspendedNb(ueLteDevs.Get(u), enbLteDevs.Get(0));
 
-    Ptr<LteUeNetDevice> ueLteDevice = ueLteDevs.Get(i)->GetObject<LteUeNetDevice>();
+    Ptr<LteUeNetDevice> ueLteDevice = ueLteDevs.Get(u)->GetObject<LteUeNetDevice>();
     Ptr<LteUeRrc> ueRrc = ueLteDevice->GetRrc();
     ueRrc->EnableLogging();
     ueRrc->SetAttribute("CIoT-Opt", BooleanValue(false));
@@ -160,20 +251,47 @@ int main(int argc, char *argv[]) {
       ueRrc->SetAttribute("EDT", BooleanValue(false));
     }
 
-    Ptr<CheckpointingPositionClient> clientApp = CreateObject<CheckpointingPositionClient>();
-    clientApp->SetAttribute("RemoteAddress", AddressValue(remoteHostAddr));
-    clientApp->SetAttribute("RemotePort", UintegerValue(ulPort));
-    clientApp->SetAttribute("Range", DoubleValue(range));
-    clientApp->SetAttribute("Node", PointerValue(ueNodes.Get(i)));
-    clientApp->SetAttribute("EnbNode", PointerValue(enbNodes.Get(0)));
-    clientApp->SetAttribute("ExtraPayloadSize", UintegerValue(packetsize_app_a + payloadSize));
-    clientApp->SetAttribute("PositionInterval", TimeValue(Seconds(syncFrequency)));
-    clientApp->SetAttribute("Interval", TimeValue(Seconds(positionInterval)));
-    ueNodes.Get(i)->AddApplication(clientApp);
-    clientApps.Add(clientApp);
-
-    clientApps.Get(i)->SetStartTime(Seconds(ns2Utility.GetEntryTimeForNode(i)));
-    clientApps.Get(i)->SetStopTime(Seconds(ns2Utility.GetExitTimeForNode(i)));
+    for (uint32_t vehicle : ueVehicles[u]) {
+      Ptr<CheckpointingPositionClient> clientApp = CreateObject<CheckpointingPositionClient>();
+      clientApp->SetAttribute("RemoteAddress", AddressValue(remoteHostAddr));
+      clientApp->SetAttribute("RemotePort", UintegerValue(ulPort));
+      clientApp->SetAttribute("Range", DoubleValue(range));
+      clientApp->SetAttribute("Node", PointerValue(ueNodes.Get(u)));
+      clientApp->SetAttribute("VehicleId", UintegerValue(vehicle));
+      clientApp->SetAttribute("EnbNode", PointerValue(enbNodes.Get(0)));
+      clientApp->SetAttribute("ExtraPayloadSize", UintegerValue(packetsize_app_a + payloadSize));
+      clientApp->SetAttribute("PositionInterval", TimeValue(Seconds(syncFrequency)));
+      clientApp->SetAttribute("Interval", TimeValue(Seconds(positionInterval)));
+      clientApp->SetAttribute("BinaryBatches", BooleanValue(binaryBatches));
+      clientApp->SetAttribute("EventDrivenCoverage", BooleanValue(eventCoverage));
+      clientApp->SetAttribute("BatchPolicy", PointerValue(CreateBatchPolicy(batchPolicy)));
+      clientApp->SetAttribute("MaxPacketSize", UintegerValue(maxPacketSize));
+      clientApp->SetAttribute("Windowed", BooleanValue(windowedRetransmission));
+      clientApp->SetAttribute("AdaptiveInterval", BooleanValue(adaptiveInterval));
+      clientApp->SetAttribute("MinInterval", TimeValue(Seconds(minInterval > 0 ? minInterval : positionInterval)));
+      clientApp->SetAttribute("MaxInterval", TimeValue(Seconds(maxInterval)));
+      clientApp->SetAttribute("MaxBacklog", UintegerValue(maxBacklog));
+      clientApp->SetAttribute("MaxBacklogBytes", UintegerValue(maxBacklogBytes));
+      clientApp->SetAttribute("BacklogTolerance", DoubleValue(backlogTolerance));
+      if (adaptiveSampling) {
+        clientApp->SetAttribute("AdaptiveSampler", PointerValue(CreateObject<AdaptiveSampler>()));
+      }
+      ueNodes.Get(u)->AddApplication(clientApp);
+      clientApps.Add(clientApp);
+
+      clientApp->SetStartTime(Seconds(ns2Utility.GetEntryTimeForNode(vehicle)));
+      clientApp->SetStopTime(Seconds(ns2Utility.GetExitTimeForNode(vehicle)));
+    }
+  }
+
+  Ptr<TrackingAccuracyEvaluator> accuracy;
+  if (evaluateAccuracy) {
+    accuracy = Create<TrackingAccuracyEvaluator>(Create<TracePositionOracle>(groundTruth),
+                                                 MakeCallback(&CheckpointingPositionServer::GetEstimatedPosition, serverApp));
+    for (uint32_t u = 0; u < ueNodes.GetN(); u++) {
+      accuracy->AddNode(ueNodes.Get(u)->GetId(), ueVehicles[u]);
+    }
+    accuracy->Start(Seconds(accuracyInterval), simTime);
   }
 
   auto start = std::chrono::system_clock::now(); 
@@ -226,6 +344,14 @@ int main(int argc, char *argv[]) {
   Ptr<LteEnbRrc> enbRrc = enbLteDevice->GetRrc();
   enbRrc->SetLogDir(logdir);
 
+  // One line per change: time, client (node and application) and interval, in seconds.
+  if (adaptiveInterval) {
+    AsciiTraceHelper ascii;
+    Ptr<OutputStreamWrapper> intervals = ascii.CreateFileStream(logdir + "intervals.tsv");
+    Config::Connect("/NodeList/*/ApplicationList/*/$ns3::CheckpointingPositionClient/SendInterval",
+                    MakeBoundCallback(&IntervalChanged, intervals));
+  }
+
   Simulator::Stop(simTime);
   Simulator::Run();
   auto end = std::chrono::system_clock::now();
@@ -233,6 +359,9 @@ int main(int argc, char *argv[]) {
   std::time_t end_time = std::chrono::system_clock::to_time_t(end);
   std::cout << "finished computation at " << std::ctime(&end_time)
               << "elapsed time: " << elapsed_seconds.count() << "s\n";
+  if (accuracy) {
+    accuracy->Report(std::cout, "checkpointing");
+  }
   Simulator::Destroy();
   return 0;
 }
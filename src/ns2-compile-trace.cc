@@ -0,0 +1,46 @@
+#include "ns3/core-module.h"
+#include "ns3/utilities-module.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ns2CompileTrace");
+
+int main(int argc, char *argv[]) {
+  std::string mobilityFile;
+  std::string outputFile;
+  double tolerance = 0;
+
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("mobilityFile", "ns-2 mobility file or SUMO FCD output to compile", mobilityFile);
+  cmd.AddValue("outputFile", "Compiled trace to write (defaults to mobilityFile with a .bin suffix)", outputFile);
+  cmd.AddValue("tolerance", "Merge waypoints as long as positions stay within this distance in meters (0 keeps them all)", tolerance);
+  cmd.Parse(argc, argv);
+
+  if (outputFile.empty()) {
+    outputFile = mobilityFile + ".bin";
+  }
+
+  if (tolerance > 0) {
+    Ptr<Ns2BinaryTrace> original = Ns2BinaryTrace::Load(mobilityFile);
+    if (original == 0) {
+      NS_FATAL_ERROR("Could not read " << mobilityFile);
+    }
+    Ptr<Ns2BinaryTrace> simplified = Ns2BinaryTrace::Simplify(original, tolerance);
+    std::cout << "simplified " << original->GetNWaypoints() << " waypoints (" << original->GetNMobilityEvents()
+              << " mobility events) into " << simplified->GetNWaypoints() << " ("
+              << simplified->GetNMobilityEvents() << " events) within " << tolerance << " m" << std::endl;
+    if (!simplified->Write(outputFile)) {
+      NS_FATAL_ERROR("Could not write " << outputFile);
+    }
+  } else if (!Ns2BinaryTrace::Compile(mobilityFile, outputFile)) {
+    NS_FATAL_ERROR("Could not compile " << mobilityFile << " into " << outputFile);
+  }
+
+  Ns2BinaryTrace trace(outputFile);
+  std::cout << "compiled " << mobilityFile << " into " << outputFile << ": "
+            << trace.GetNNodes() << " nodes, " << trace.GetNWaypoints() << " waypoints, "
+            << trace.GetSimulationTime() << "s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,179 @@
+#include "ns3/core-module.h"
+#include "ns3/utilities-module.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ns2GenerateTrace");
+
+// Waypoint columns of the vehicles generated so far, grouped by vehicle.
+struct TraceColumns {
+  std::vector<double> times;
+  std::vector<double> xs;
+  std::vector<double> ys;
+  std::vector<double> speeds;
+
+  void Add(double time, const Vector &destination, double speed) {
+    times.push_back(time);
+    xs.push_back(destination.x);
+    ys.push_back(destination.y);
+    speeds.push_back(speed);
+  }
+
+  void Clear() {
+    times.clear();
+    xs.clear();
+    ys.clear();
+    speeds.clear();
+  }
+};
+
+// Drives along a lane at its speed limit, with one setdest per segment of its shape.
+static void DriveLane(const RoadLane &lane, double &time, Vector &position, TraceColumns &columns) {
+  for (const Vector &point : lane.shape) {
+    double distance = CalculateDistance(position, point);
+    if (distance < 1e-6 || lane.speed <= 0) {
+      continue;
+    }
+    columns.Add(time, point, lane.speed);
+    time += distance / lane.speed;
+    position = point;
+  }
+}
+
+// Picks a random trip like randomTrips.py: any two edges whose ends are at
+// least minDistance apart (in a straight line) and connected by a route.
+static void PickTrip(RoadNetwork &network, std::mt19937 &rng, double minDistance, uint32_t &from,
+                     std::vector<uint32_t> &route) {
+  std::uniform_int_distribution<uint32_t> edge(0, network.GetNEdges() - 1);
+  for (uint32_t attempt = 0; attempt < 100000; attempt++) {
+    from = edge(rng);
+    uint32_t to = edge(rng);
+    const RoadLane &start = network.GetEdge(from).lane;
+    const RoadLane &end = network.GetEdge(to).lane;
+    if (start.shape.empty() || end.shape.empty() ||
+        CalculateDistance(start.shape.front(), end.shape.back()) < minDistance) {
+      continue;
+    }
+    if (network.FindRoute(from, to, route)) {
+      return;
+    }
+  }
+  NS_FATAL_ERROR("No pair of connected edges is at least " << minDistance << " m apart");
+}
+
+// Writes the waypoints of one vehicle as an ns-2 mobility script.
+static void WriteVehicle(std::ostream &output, uint32_t nodeId, const Ns2BinaryTraceNode &node,
+                         const TraceColumns &columns) {
+  char line[128];
+  int n = std::snprintf(line, sizeof(line), "$node_(%u) set X_ %.3f\n$node_(%u) set Y_ %.3f\n$node_(%u) set Z_ 0\n",
+                        nodeId, node.x, nodeId, node.y, nodeId);
+  output.write(line, n);
+  for (uint32_t i = 0; i < columns.times.size(); i++) {
+    n = std::snprintf(line, sizeof(line), "$ns_ at %.3f \"$node_(%u) setdest %.3f %.3f %.3f\"\n", columns.times[i],
+                      nodeId, columns.xs[i], columns.ys[i], columns.speeds[i]);
+    output.write(line, n);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::string netFile = "sumo/grid.net.xml";
+  std::string outputFile;
+  uint32_t vehicles = 1000;
+  double endTime = 3600;
+  double minDistance = 1200;
+  uint32_t seed = 1;
+  bool binary = false;
+
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("netFile", "SUMO network to drive on", netFile);
+  cmd.AddValue("outputFile", "Trace to write (defaults to generated/mobility.tcl, or .bin when binary)", outputFile);
+  cmd.AddValue("vehicles", "Number of vehicles", vehicles);
+  cmd.AddValue("endTime", "Departures are spread evenly between 1 s and this time", endTime);
+  cmd.AddValue("minDistance", "Minimum straight line distance between the start and the end of a trip", minDistance);
+  cmd.AddValue("seed", "Seed of the trip generator", seed);
+  cmd.AddValue("binary", "Write a compiled trace instead of an ns-2 script", binary);
+  cmd.Parse(argc, argv);
+
+  if (outputFile.empty()) {
+    outputFile = binary ? "generated/mobility.bin" : "generated/mobility.tcl";
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  RoadNetwork network(netFile);
+  if (!network.IsValid()) {
+    NS_FATAL_ERROR("Could not read network " << netFile);
+  }
+
+  std::ofstream script;
+  if (!binary) {
+    script.open(outputFile.c_str(), std::ios::trunc);
+    if (!script) {
+      NS_FATAL_ERROR("Could not write " << outputFile);
+    }
+  }
+
+  // Vehicles drive their whole route at the speed limits, without
+  // interacting with each other, like an empty network in SUMO.
+  std::mt19937 rng(seed);
+  std::vector<Ns2BinaryTraceNode> nodes(vehicles);
+  TraceColumns columns;
+  std::vector<uint32_t> route;
+  double period = (endTime - 1) / std::max(vehicles, 1u);
+  uint64_t nWaypoints = 0;
+  for (uint32_t i = 0; i < vehicles; i++) {
+    uint32_t edge;
+    PickTrip(network, rng, minDistance, edge, route);
+
+    Ns2BinaryTraceNode &node = nodes[i];
+    std::size_t first = columns.times.size();
+    double time = 1 + i * period;
+    Vector position = network.GetEdge(edge).lane.shape.front();
+    node.entryTime = time;
+    node.x = position.x;
+    node.y = position.y;
+    node.z = 0;
+
+    DriveLane(network.GetEdge(edge).lane, time, position, columns);
+    for (uint32_t connection : route) {
+      const RoadConnection &c = network.GetEdge(edge).connections[connection];
+      for (const RoadLane &lane : c.via) {
+        DriveLane(lane, time, position, columns);
+      }
+      edge = c.to;
+      DriveLane(network.GetEdge(edge).lane, time, position, columns);
+    }
+    // Stop at the end of the route, which is also where the vehicle leaves.
+    columns.Add(time, position, 0);
+    node.exitTime = time;
+    node.nWaypoints = columns.times.size() - first;
+    nWaypoints += node.nWaypoints;
+
+    if (!binary) {
+      WriteVehicle(script, i, node, columns);
+      columns.Clear();
+    }
+  }
+
+  if (binary) {
+    Ptr<Ns2BinaryTrace> trace = Ns2BinaryTrace::FromColumns(nodes, columns.times, columns.xs, columns.ys, columns.speeds);
+    if (!trace->Write(outputFile)) {
+      NS_FATAL_ERROR("Could not write " << outputFile);
+    }
+  } else {
+    script.close();
+    if (!script) {
+      NS_FATAL_ERROR("Could not write " << outputFile);
+    }
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "generated " << vehicles << " vehicles, " << nWaypoints << " waypoints on " << network.GetNEdges()
+            << " edges into " << outputFile << " in " << elapsed.count() << "s" << std::endl;
+  return 0;
+}
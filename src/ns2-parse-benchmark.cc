@@ -0,0 +1,144 @@
+#include "ns3/core-module.h"
+#include "ns3/utilities-module.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <sys/stat.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ns2ParseBenchmark");
+
+// Line-by-line std::regex parser that Ns2NodeUtility used before the
+// single-pass scanner. Kept here as the baseline for the comparison.
+static uint32_t LegacyParse(const std::string &fileName) {
+  std::ifstream input(fileName);
+  std::string line;
+  std::vector<uint32_t> node_ids;
+  std::map<uint32_t, std::pair<double, double>> node_times;
+
+  while (std::getline(input, line)) {
+    std::smatch sm;
+    std::regex r("\\$ns_ at (\\d*.\\d) \"\\$node_\\((\\d*)\\)");
+    if (std::regex_search(line, sm, r)) {
+      uint32_t id = std::stoi(sm[2]);
+      double new_latest = std::stof(sm[1]);
+
+      if (std::find(node_ids.begin(), node_ids.end(), id) != node_ids.end()) {
+        double entry_time = std::get<0>(node_times[id]);
+        node_times[id] = std::make_pair(entry_time, new_latest);
+      } else {
+        node_times[id] = std::make_pair(new_latest, new_latest);
+      }
+      node_ids.push_back(id);
+    }
+  }
+
+  return node_times.size();
+}
+
+// Throughput in MB/s of a parse function run iterations times.
+template <typename F>
+static double Throughput(double sizeMb, uint32_t iterations, F parse) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    parse();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return sizeMb * iterations / elapsed.count();
+}
+
+// Times Ns2NodeUtility and Ns2BinaryTrace::Load with every thread count and
+// reports the speedup over the serial constructor.
+static void ThreadScaling(const std::string &fileName, double sizeMb, uint32_t iterations,
+                          const std::string &threads) {
+  double serialLifetimes =
+      Throughput(sizeMb, iterations, [&]() { Ns2NodeUtility ns2Utility(fileName); });
+  double serialLoad = Throughput(sizeMb, iterations, [&]() { Ns2BinaryTrace::Load(fileName); });
+
+  std::istringstream counts(threads);
+  std::string count;
+  while (std::getline(counts, count, ',')) {
+    uint32_t n = std::stoul(count);
+    double lifetimes =
+        Throughput(sizeMb, iterations, [&]() { Ns2NodeUtility ns2Utility(fileName, n); });
+    double load = Throughput(sizeMb, iterations, [&]() { Ns2BinaryTrace::Load(fileName, n); });
+
+    std::cout << "  " << std::setw(2) << n << " threads: lifetimes " << lifetimes << " MB/s ("
+              << lifetimes / serialLifetimes << "x), load " << load << " MB/s ("
+              << load / serialLoad << "x)" << std::endl;
+  }
+}
+
+static double FileSizeMb(const std::string &fileName) {
+  struct stat st;
+  if (stat(fileName.c_str(), &st) != 0) {
+    NS_FATAL_ERROR("Cannot stat " << fileName);
+  }
+  return st.st_size / (1024.0 * 1024.0);
+}
+
+int main(int argc, char *argv[]) {
+  std::string traceFiles = "50_ues.tcl,100_ues.tcl";
+  uint32_t iterations = 20;
+  bool legacy = true;
+  std::string threads = "1,2,4,8";
+
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("traceFiles", "Comma separated list of ns-2 mobility files", traceFiles);
+  cmd.AddValue("iterations", "Parses per file", iterations);
+  cmd.AddValue("legacy", "Also time the regex based parser", legacy);
+  cmd.AddValue("threads", "Comma separated list of parse thread counts to compare", threads);
+  cmd.Parse(argc, argv);
+
+  std::cout << std::fixed << std::setprecision(2);
+
+  std::istringstream files(traceFiles);
+  std::string fileName;
+  while (std::getline(files, fileName, ',')) {
+    double sizeMb = FileSizeMb(fileName);
+    uint32_t nodes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+      Ns2NodeUtility ns2Utility(fileName);
+      nodes = ns2Utility.GetNNodes();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double scanner = sizeMb * iterations / elapsed.count();
+
+    std::cout << fileName << " (" << sizeMb << " MB, " << nodes << " nodes)" << std::endl;
+    std::cout << "  scanner: " << scanner << " MB/s" << std::endl;
+
+    ThreadScaling(fileName, sizeMb, iterations, threads);
+
+    // The first call writes the sidecar cache, the timed ones only map it.
+    Ns2BinaryTrace::LoadCached(fileName);
+    double cached = Throughput(sizeMb, iterations, [&]() {
+      Ns2NodeUtility ns2Utility(Ns2BinaryTrace::LoadCached(fileName));
+    });
+    std::cout << "  cached:  " << cached << " MB/s (" << cached / scanner << "x)" << std::endl;
+
+    if (legacy) {
+      uint32_t legacyNodes = 0;
+      start = std::chrono::steady_clock::now();
+      for (uint32_t i = 0; i < iterations; i++) {
+        legacyNodes = LegacyParse(fileName);
+      }
+      elapsed = std::chrono::steady_clock::now() - start;
+      double regex = sizeMb * iterations / elapsed.count();
+
+      std::cout << "  regex:   " << regex << " MB/s (" << scanner / regex << "x)" << std::endl;
+      if (legacyNodes != nodes) {
+        std::cout << "  node count mismatch: regex found " << legacyNodes << std::endl;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/position-client.h"
+#include "ns3/position-packet.h"
+#include "ns3/position-sample.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <streambuf>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("PositionSendBenchmark");
+
+// Every allocation in the process goes through here, so the count between
+// two points is what the code in between allocated.
+static uint64_t g_allocations = 0;
+
+void *operator new(std::size_t size) {
+  ++g_allocations;
+  void *p = std::malloc(size ? size : 1);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+// Stands for the log file the drivers write the clients' "sent" lines to:
+// buffered like a file stream, but it keeps only the count of the bytes.
+class CountingBuffer : public std::streambuf {
+public:
+  CountingBuffer() : m_bytes(0) { setp(m_buffer, m_buffer + sizeof(m_buffer)); }
+  uint64_t GetBytes(void) const { return m_bytes + (pptr() - pbase()); }
+
+protected:
+  virtual int_type overflow(int_type c) {
+    m_bytes += pptr() - pbase();
+    setp(m_buffer, m_buffer + sizeof(m_buffer));
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      sputc(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+private:
+  char m_buffer[4096];
+  uint64_t m_bytes;
+};
+
+// Header bytes the scenarios add to the payload size (see packetsize_app_a).
+static const uint32_t kPacketOverhead = 49;
+
+// How the clients built and logged a batch before: text in an
+// std::ostringstream, the padding as a string of dots, one more copy into
+// the packet, and the whole string again in the log line.
+static Ptr<Packet> LegacySend(const std::vector<PositionSample> &samples, uint32_t padding, std::ostream &log) {
+  std::ostringstream pos;
+  for (auto sample = samples.rbegin(); sample != samples.rend(); ++sample) {
+    pos << sample->id << " " << sample->x << "," << sample->y << "," << sample->z << "\n";
+  }
+  pos << std::string(padding, '.');
+  std::string msg = pos.str();
+  Ptr<Packet> packet = Create<Packet>(reinterpret_cast<const uint8_t *>(msg.c_str()), msg.size());
+  log << "sent '" << msg << "' to 1.0.0.1 port 9\n";
+  return packet;
+}
+
+// What PositionClient does for each packet: EncodeBatch into the buffer it
+// keeps across sends, then Transmit's CreatePositionPacket and "sent" line.
+static Ptr<Packet> ClientSend(const std::vector<PositionSample> &samples, const PositionBatchFormat &format,
+                              uint32_t padding, std::vector<uint8_t> &payload, std::ostream &log) {
+  payload.clear();
+  PositionCodec::Encode(payload, samples.data(), samples.size(), format);
+  Ptr<Packet> packet = CreatePositionPacket(payload, padding);
+  log << "sent '" << DescribePositionPayload(payload, padding) << "' to 1.0.0.1 port 9\n";
+  return packet;
+}
+
+// Runs send iterations times after a warm up and prints the allocations and
+// the time per call.
+template <typename F>
+static void Measure(const std::string &label, uint32_t iterations, F send) {
+  uint32_t bytes = 0;
+  for (uint32_t i = 0; i < 100; i++) {
+    bytes = send()->GetSize();
+  }
+
+  uint64_t allocations = g_allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    send();
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << "  " << std::left << std::setw(8) << label << std::right << std::setw(6) << bytes << " B  "
+            << std::setw(6) << static_cast<double>(g_allocations - allocations) / iterations << " allocs  "
+            << std::setw(8) << elapsed.count() / iterations << " ns" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  std::string payloadSizes = "1024,4096";
+  uint32_t positions = 10;
+  uint32_t iterations = 100000;
+  bool log = true;
+
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("payloadSizes", "Comma separated list of payloadSize values, as given to the scenarios", payloadSizes);
+  cmd.AddValue("positions", "Positions per batch (AmountPositionsToSend)", positions);
+  cmd.AddValue("iterations", "Sends per measurement", iterations);
+  cmd.AddValue("log", "Write the clients' \"sent\" line for each packet, as the scenarios do", log);
+  cmd.Parse(argc, argv);
+
+  // A vehicle driving diagonally at about 14 m/s, one fix per second.
+  std::vector<PositionSample> samples(positions);
+  for (uint32_t i = 0; i < positions; i++) {
+    samples[i].id = 1000 + i;
+    samples[i].timestamp = Seconds(120 + i).GetTimeStep();
+    samples[i].x = 213.417 + 10.1 * i;
+    samples[i].y = 688.052 - 9.7 * i;
+    samples[i].z = 0;
+    samples[i].speed = 14.0;
+  }
+
+  CountingBuffer sink;
+  std::ostream logStream(&sink);
+  if (!log) {
+    logStream.setstate(std::ios::badbit);
+  }
+
+  PositionBatchFormat text = PositionCodec::GetFormat(false, 0, Vector(500, 500, 25));
+  PositionBatchFormat binary = PositionCodec::GetFormat(true, 0, Vector(500, 500, 25));
+
+  std::cout << std::fixed << std::setprecision(1);
+
+  std::vector<uint8_t> payload;
+  std::istringstream sizes(payloadSizes);
+  std::string size;
+  while (std::getline(sizes, size, ',')) {
+    uint32_t padding = kPacketOverhead + std::stoul(size);
+    std::cout << "payloadSize " << size << ", " << positions << " positions" << std::endl;
+    Measure("legacy", iterations, [&]() { return LegacySend(samples, padding, logStream); });
+    Measure("text", iterations, [&]() { return ClientSend(samples, text, padding, payload, logStream); });
+    Measure("binary", iterations, [&]() { return ClientSend(samples, binary, padding, payload, logStream); });
+  }
+
+  NS_LOG_INFO("logged " << sink.GetBytes() << " bytes");
+  return 0;
+}
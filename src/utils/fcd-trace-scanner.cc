@@ -0,0 +1,234 @@
+#include "fcd-trace-scanner.h"
+#include "trace-text.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3
+{
+  namespace
+  {
+    using TraceText::IsName;
+    using TraceText::IsTag;
+    using TraceText::NextAttribute;
+    using TraceText::ParseDouble;
+    using TraceText::SkipPast;
+    using TraceText::TagEnd;
+  }
+
+  FcdTraceScanner::FcdTraceScanner (const char *begin, const char *end)
+    : m_cur (begin),
+      m_end (end),
+      m_time (0),
+      m_step (0),
+      m_nPending (0),
+      m_pendingPos (0)
+  {
+  }
+
+  bool
+  FcdTraceScanner::IsFcdTrace (const char *begin, const char *end)
+  {
+    // The root element comes right after the XML declaration and comments.
+    const char *limit = begin + std::min<std::size_t> (end - begin, 64 * 1024);
+    for (const char *p = begin; p < limit; ++p)
+      {
+	p = static_cast<const char *> (std::memchr (p, '<', limit - p));
+	if (p == 0)
+	  {
+	    return false;
+	  }
+	if (IsTag (p + 1, limit, "fcd-export", 10))
+	  {
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  bool
+  FcdTraceScanner::Next (Ns2TraceRecord &record)
+  {
+    while (m_pendingPos == m_nPending)
+      {
+	m_nPending = 0;
+	m_pendingPos = 0;
+	if (!NextElement ())
+	  {
+	    return false;
+	  }
+      }
+    record = m_pending[m_pendingPos++];
+    return true;
+  }
+
+  bool
+  FcdTraceScanner::NextElement (void)
+  {
+    const char *p = static_cast<const char *> (std::memchr (m_cur, '<', m_end - m_cur));
+    if (p == 0)
+      {
+	m_cur = m_end;
+	return false;
+      }
+    ++p;
+
+    if (p < m_end && *p == '!')
+      {
+	m_cur = (m_end - p >= 3 && std::memcmp (p, "!--", 3) == 0)
+	  ? SkipPast (p + 3, m_end, "-->", 3) : TagEnd (p, m_end);
+	return true;
+      }
+    if (p < m_end && *p == '?')
+      {
+	m_cur = SkipPast (p, m_end, "?>", 2);
+	return true;
+      }
+
+    const char *tagEnd = TagEnd (p, m_end);
+    m_cur = tagEnd < m_end ? tagEnd + 1 : m_end;
+    bool selfClosing = tagEnd > p && tagEnd[-1] == '/';
+
+    if (IsTag (p, m_end, "vehicle", 7))
+      {
+	Vehicle (p + 7, tagEnd);
+      }
+    else if (IsTag (p, m_end, "timestep", 8))
+      {
+	BeginTimestep (p + 8, tagEnd);
+	if (selfClosing)
+	  {
+	    EndTimestep ();
+	  }
+      }
+    else if (IsTag (p, m_end, "/timestep", 9))
+      {
+	EndTimestep ();
+      }
+    return true;
+  }
+
+  void
+  FcdTraceScanner::BeginTimestep (const char *p, const char *end)
+  {
+    m_step++;
+    const char *name;
+    std::size_t nameLen;
+    const char *value;
+    const char *valueEnd;
+    while (NextAttribute (p, end, name, nameLen, value, valueEnd))
+      {
+	if (IsName (name, nameLen, "time", 4))
+	  {
+	    ParseDouble (value, valueEnd, m_time);
+	  }
+      }
+  }
+
+  void
+  FcdTraceScanner::EndTimestep (void)
+  {
+    // Vehicles missing from the timestep have left the simulation.
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < m_active.size (); i++)
+      {
+	uint32_t nodeId = m_active[i];
+	if (m_lastStep[nodeId] == m_step)
+	  {
+	    m_active[kept++] = nodeId;
+	  }
+	else
+	  {
+	    m_state[nodeId] = REMOVED;
+	  }
+      }
+    m_active.resize (kept);
+  }
+
+  void
+  FcdTraceScanner::Vehicle (const char *p, const char *end)
+  {
+    const char *id = 0;
+    std::size_t idLen = 0;
+    double x = 0;
+    double y = 0;
+    double speed = 0;
+
+    const char *name;
+    std::size_t nameLen;
+    const char *value;
+    const char *valueEnd;
+    while (NextAttribute (p, end, name, nameLen, value, valueEnd))
+      {
+	if (IsName (name, nameLen, "id", 2))
+	  {
+	    id = value;
+	    idLen = valueEnd - value;
+	  }
+	else if (IsName (name, nameLen, "x", 1))
+	  {
+	    ParseDouble (value, valueEnd, x);
+	  }
+	else if (IsName (name, nameLen, "y", 1))
+	  {
+	    ParseDouble (value, valueEnd, y);
+	  }
+	else if (IsName (name, nameLen, "speed", 5))
+	  {
+	    ParseDouble (value, valueEnd, speed);
+	  }
+      }
+    if (id == 0)
+      {
+	return;
+      }
+
+    m_key.assign (id, idLen);
+    std::unordered_map<std::string, uint32_t>::iterator it = m_ids.find (m_key);
+    uint32_t nodeId;
+    if (it == m_ids.end ())
+      {
+	nodeId = m_ids.size ();
+	m_ids.insert (std::make_pair (m_key, nodeId));
+	m_state.push_back (ACTIVE);
+	m_lastStep.push_back (m_step);
+	m_active.push_back (nodeId);
+	Queue (Ns2TraceRecord::SET_X, nodeId, x);
+	Queue (Ns2TraceRecord::SET_Y, nodeId, y);
+	Queue (Ns2TraceRecord::SET_Z, nodeId, 0);
+      }
+    else
+      {
+	nodeId = it->second;
+	if (m_state[nodeId] == REMOVED)
+	  {
+	    m_state[nodeId] = IGNORED;
+	  }
+	if (m_state[nodeId] == IGNORED)
+	  {
+	    return;
+	  }
+	m_lastStep[nodeId] = m_step;
+      }
+
+    Ns2TraceRecord &record = m_pending[m_nPending++];
+    record.kind = Ns2TraceRecord::SETDEST;
+    record.nodeId = nodeId;
+    record.time = m_time;
+    record.x = x;
+    record.y = y;
+    record.speed = speed;
+  }
+
+  void
+  FcdTraceScanner::Queue (Ns2TraceRecord::Kind kind, uint32_t nodeId, double x)
+  {
+    Ns2TraceRecord &record = m_pending[m_nPending++];
+    record.kind = kind;
+    record.nodeId = nodeId;
+    record.time = m_time;
+    record.x = x;
+    record.y = 0;
+    record.speed = 0;
+  }
+}
@@ -0,0 +1,81 @@
+#ifndef SUMOTRACEEXAMPLE_FCD_TRACE_SCANNER_H_
+#define SUMOTRACEEXAMPLE_FCD_TRACE_SCANNER_H_
+
+#include "ns2-trace-scanner.h"
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+  /**
+   * Streaming reader for SUMO floating car data (sumo --fcd-output) that
+   * produces the same records Ns2TraceScanner reads from the ns-2 script
+   * traceExporter.py would write for it:
+   *
+   *  - vehicles are numbered in order of first appearance;
+   *  - the first time a vehicle appears its position is reported with
+   *    SET_X, SET_Y and SET_Z (0), then every timestep it appears in gives a
+   *    SETDEST towards its position at its speed;
+   *  - a vehicle that is missing from a timestep has left, and is ignored if
+   *    it shows up again later (traceExporter's default gap check).
+   *
+   * The XML is tokenized in place over a character range (usually a
+   * MappedFile), one element at a time, so memory only grows with the number
+   * of distinct vehicles, not with the length of the trace.
+   */
+  class FcdTraceScanner
+  {
+  public:
+    FcdTraceScanner (const char *begin, const char *end);
+    /**
+     * Scans forward to the next record.
+     * \param record filled in with the record
+     * \return false once the end of the range is reached
+     */
+    bool Next (Ns2TraceRecord &record);
+    /**
+     * \param begin of the file contents
+     * \param end of the file contents
+     * \return true if the range looks like a SUMO FCD export
+     */
+    static bool IsFcdTrace (const char *begin, const char *end);
+
+  private:
+    enum VehicleState
+    {
+      ACTIVE,  /**< present in the current timestep */
+      REMOVED, /**< missing from a timestep, so it has left */
+      IGNORED  /**< came back after having left */
+    };
+
+    /**
+     * Reads the next element and queues the records it produces.
+     * \return false at the end of the range
+     */
+    bool NextElement (void);
+    void BeginTimestep (const char *p, const char *end);
+    void EndTimestep (void);
+    void Vehicle (const char *p, const char *end);
+    void Queue (Ns2TraceRecord::Kind kind, uint32_t nodeId, double x);
+
+    const char *m_cur;         /**< next character to read */
+    const char *m_end;         /**< end of the range */
+
+    double m_time;             /**< time of the current timestep */
+    uint32_t m_step;           /**< number of the current timestep */
+    std::unordered_map<std::string, uint32_t> m_ids; /**< node id of every vehicle seen */
+    std::string m_key;         /**< reused buffer for id lookups */
+    std::vector<uint8_t> m_state;      /**< VehicleState by node id */
+    std::vector<uint32_t> m_lastStep;  /**< last timestep a node was seen in, by node id */
+    std::vector<uint32_t> m_active;    /**< ids of the nodes that have not left yet */
+
+    Ns2TraceRecord m_pending[4]; /**< records produced by the last element */
+    uint32_t m_nPending;       /**< number of records in m_pending */
+    uint32_t m_pendingPos;     /**< next record of m_pending to return */
+  };
+}
+
+#endif
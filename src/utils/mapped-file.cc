@@ -0,0 +1,83 @@
+#include "mapped-file.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+  MappedFile::MappedFile (std::string file_name)
+    : m_data (0),
+      m_size (0),
+      m_open (false)
+  {
+    int fd = open (file_name.c_str (), O_RDONLY);
+    if (fd < 0)
+      {
+	return;
+      }
+
+    struct stat st;
+    if (fstat (fd, &st) == 0)
+      {
+	m_open = true;
+	m_size = st.st_size;
+	if (m_size > 0)
+	  {
+	    void *addr = mmap (0, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	    if (addr == MAP_FAILED)
+	      {
+		m_open = false;
+		m_size = 0;
+	      }
+	    else
+	      {
+		madvise (addr, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const char *> (addr);
+	      }
+	  }
+      }
+    close (fd);
+  }
+
+  MappedFile::~MappedFile ()
+  {
+    if (m_data != 0)
+      {
+	munmap (const_cast<char *> (m_data), m_size);
+      }
+  }
+
+  bool
+  MappedFile::IsOpen () const
+  {
+    return m_open;
+  }
+
+  const char *
+  MappedFile::GetData () const
+  {
+    return m_data;
+  }
+
+  std::size_t
+  MappedFile::GetSize () const
+  {
+    return m_size;
+  }
+
+  void
+  MappedFile::Release (std::size_t offset, std::size_t length) const
+  {
+    if (m_data == 0 || offset >= m_size)
+      {
+	return;
+      }
+    std::size_t page = sysconf (_SC_PAGESIZE);
+    std::size_t begin = offset - offset % page;
+    std::size_t end = std::min (offset + length, m_size);
+    madvise (const_cast<char *> (m_data) + begin, end - begin, MADV_DONTNEED);
+  }
+}
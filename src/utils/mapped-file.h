@@ -0,0 +1,50 @@
+#ifndef SUMOTRACEEXAMPLE_MAPPED_FILE_H_
+#define SUMOTRACEEXAMPLE_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace ns3
+{
+  /**
+   * Read-only memory mapping of a whole file. Pages are shared through the
+   * OS page cache, so several simulation processes reading the same trace
+   * only pay for it once. The mapping is released on destruction.
+   */
+  class MappedFile
+  {
+  public:
+    MappedFile (std::string file_name);
+    ~MappedFile ();
+    /**
+     * \return true if the file could be opened and mapped (an empty file counts as open)
+     */
+    bool IsOpen () const;
+    /**
+     * \return pointer to the first byte of the file, or 0 if the file is empty or not open
+     */
+    const char *GetData () const;
+    /**
+     * \return the size of the file in bytes
+     */
+    std::size_t GetSize () const;
+    /**
+     * Drops the pages covering a range of the file from the process. They
+     * are read back from the page cache if the range is accessed again, so
+     * this only trades resident memory for page faults.
+     * \param offset of the first byte of the range
+     * \param length of the range in bytes
+     */
+    void Release (std::size_t offset, std::size_t length) const;
+
+  private:
+    MappedFile (const MappedFile &);
+    MappedFile &operator= (const MappedFile &);
+
+    const char *m_data; /**< start of the mapping */
+    std::size_t m_size; /**< length of the mapping in bytes */
+    bool m_open; /**< whether the file could be opened */
+  };
+}
+
+#endif
@@ -0,0 +1,153 @@
+#include "ns2-binary-mobility-helper.h"
+#include "ns2-trace-mobility-model.h"
+
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/node-list.h"
+#include "ns3/simulator.h"
+
+#include <cmath>
+
+namespace ns3
+{
+  Ns2BinaryMobilityHelper::Ns2BinaryMobilityHelper (std::string file_name)
+    : m_trace (Ns2BinaryTrace::Load (file_name)),
+      m_streaming (false)
+  {
+  }
+
+  Ns2BinaryMobilityHelper::Ns2BinaryMobilityHelper (Ptr<Ns2BinaryTrace> trace)
+    : m_trace (trace),
+      m_streaming (false)
+  {
+  }
+
+  void
+  Ns2BinaryMobilityHelper::SetStreaming (bool streaming)
+  {
+    m_streaming = streaming;
+  }
+
+  void
+  Ns2BinaryMobilityHelper::Install () const
+  {
+    uint32_t n = std::min (m_trace->GetNNodes (), NodeList::GetNNodes ());
+    for (uint32_t i = 0; i < n; i++)
+      {
+	Install (NodeList::GetNode (i), std::vector<uint32_t> (1, i));
+      }
+  }
+
+  void
+  Ns2BinaryMobilityHelper::Install (NodeContainer nodes) const
+  {
+    uint32_t n = std::min (m_trace->GetNNodes (), nodes.GetN ());
+    for (uint32_t i = 0; i < n; i++)
+      {
+	Install (nodes.Get (i), std::vector<uint32_t> (1, i));
+      }
+  }
+
+  void
+  Ns2BinaryMobilityHelper::Install (Ptr<Node> node, const std::vector<uint32_t> &nodeIds) const
+  {
+    std::vector<uint32_t> tracks;
+    for (uint32_t i = 0; i < nodeIds.size (); i++)
+      {
+	if (m_trace->GetNode (nodeIds[i]).entryTime >= 0)
+	  {
+	    tracks.push_back (nodeIds[i]);
+	  }
+      }
+    if (tracks.empty ())
+      {
+	return;
+      }
+
+    if (m_streaming)
+      {
+	Ptr<Ns2TraceMobilityModel> model = CreateObject<Ns2TraceMobilityModel> ();
+	node->AggregateObject (model);
+	model->SetTracks (m_trace, tracks);
+	return;
+      }
+
+    Ptr<ConstantVelocityMobilityModel> model = node->GetObject<ConstantVelocityMobilityModel> ();
+    if (model == 0)
+      {
+	model = CreateObject<ConstantVelocityMobilityModel> ();
+	node->AggregateObject (model);
+      }
+    model->SetPosition (m_trace->GetInitialPosition (tracks[0]));
+
+    EventId stopEvent;
+    double arrival = ScheduleTrack (model, tracks[0], stopEvent);
+    for (uint32_t i = 1; i < tracks.size (); i++)
+      {
+	// The next vehicle enters at its own initial position and at rest; a
+	// movement of the previous one that is still under way is dropped.
+	double entry = m_trace->GetNode (tracks[i]).entryTime;
+	if (arrival > entry)
+	  {
+	    stopEvent.Cancel ();
+	  }
+	Simulator::Schedule (Seconds (entry), &ConstantVelocityMobilityModel::SetVelocity, model, Vector ());
+	Simulator::Schedule (Seconds (entry), &MobilityModel::SetPosition, model, m_trace->GetInitialPosition (tracks[i]));
+	arrival = ScheduleTrack (model, tracks[i], stopEvent);
+      }
+  }
+
+  double
+  Ns2BinaryMobilityHelper::ScheduleTrack (Ptr<ConstantVelocityMobilityModel> model, uint32_t nodeId, EventId &stopEvent) const
+  {
+    const Ns2BinaryTraceNode &entry = m_trace->GetNode (nodeId);
+    Vector position = m_trace->GetInitialPosition (nodeId);
+
+    const double *times = m_trace->GetTimes () + entry.firstWaypoint;
+    const double *xs = m_trace->GetX () + entry.firstWaypoint;
+    const double *ys = m_trace->GetY () + entry.firstWaypoint;
+    const double *speeds = m_trace->GetSpeeds () + entry.firstWaypoint;
+
+    // Same bookkeeping as Ns2MobilityHelper: each movement starts from where
+    // the previous one actually got to, and its stop event is dropped when
+    // a new setdest arrives before the destination was reached.
+    Vector velocity;
+    double arrival = 0;
+    for (uint64_t w = 0; w < entry.nWaypoints; w++)
+      {
+	double at = times[w];
+	if (arrival > at)
+	  {
+	    position.x -= velocity.x * (arrival - at);
+	    position.y -= velocity.y * (arrival - at);
+	    stopEvent.Cancel ();
+	  }
+
+	velocity = Vector ();
+	arrival = at;
+	if (speeds[w] == 0)
+	  {
+	    stopEvent = Simulator::Schedule (Seconds (at), &ConstantVelocityMobilityModel::SetVelocity, model, velocity);
+	    continue;
+	  }
+	if (speeds[w] < 0)
+	  {
+	    continue;
+	  }
+
+	double dx = xs[w] - position.x;
+	double dy = ys[w] - position.y;
+	double time = std::sqrt (dx * dx + dy * dy) / speeds[w];
+	if (time == 0)
+	  {
+	    continue;
+	  }
+	velocity = Vector (dx / time, dy / time, 0);
+	Simulator::Schedule (Seconds (at), &ConstantVelocityMobilityModel::SetVelocity, model, velocity);
+	stopEvent = Simulator::Schedule (Seconds (at + time), &ConstantVelocityMobilityModel::SetVelocity, model, Vector ());
+	position.x += velocity.x * time;
+	position.y += velocity.y * time;
+	arrival = at + time;
+      }
+    return arrival;
+  }
+}
@@ -0,0 +1,74 @@
+#ifndef SUMOTRACEEXAMPLE_NS2_BINARY_MOBILITY_HELPER_H_
+#define SUMOTRACEEXAMPLE_NS2_BINARY_MOBILITY_HELPER_H_
+
+#include "ns2-binary-trace.h"
+
+#include "ns3/event-id.h"
+#include "ns3/node-container.h"
+#include "ns3/ptr.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+  class ConstantVelocityMobilityModel;
+
+  /**
+   * Counterpart of Ns2MobilityHelper for traces in the layout of
+   * Ns2BinaryTrace, either compiled or loaded in memory. The setdest
+   * semantics are the same: every waypoint sets a constant velocity towards
+   * its destination, and the node stops once it gets there unless a later
+   * waypoint takes over first.
+   */
+  class Ns2BinaryMobilityHelper
+  {
+  public:
+    Ns2BinaryMobilityHelper (std::string file_name);
+    /**
+     * \param trace already loaded with Ns2BinaryTrace::Load
+     */
+    Ns2BinaryMobilityHelper (Ptr<Ns2BinaryTrace> trace);
+    /**
+     * Installs mobility on the nodes of NodeList whose id appears in the
+     * trace, like Ns2MobilityHelper::Install.
+     */
+    void Install () const;
+    /**
+     * Installs the movement of trace node i on the i-th node of the container.
+     * \param nodes to install mobility on
+     */
+    void Install (NodeContainer nodes) const;
+    /**
+     * Installs on one node the movements of several trace nodes whose
+     * lifetimes do not overlap, one after the other, e.g. the nodes of one
+     * slot of Ns2NodeUtility::AssignSlots. At the entry time of each trace
+     * node the node jumps to its initial position.
+     * \param node to install mobility on
+     * \param nodeIds of the trace nodes, by increasing entry time
+     */
+    void Install (Ptr<Node> node, const std::vector<uint32_t> &nodeIds) const;
+    /**
+     * Installs Ns2TraceMobilityModel instead of ConstantVelocityMobilityModel,
+     * so that waypoints are read in chunks while the simulation runs instead
+     * of being scheduled up front.
+     * \param streaming whether to use the streaming model
+     */
+    void SetStreaming (bool streaming);
+
+  private:
+    /**
+     * Schedules the waypoints of one trace node on a model, starting from its initial position.
+     * \param model to move
+     * \param nodeId of the trace node
+     * \param stopEvent the pending stop of the last movement, updated
+     * \return the time the last movement reaches its destination
+     */
+    double ScheduleTrack (Ptr<ConstantVelocityMobilityModel> model, uint32_t nodeId, EventId &stopEvent) const;
+
+    Ptr<Ns2BinaryTrace> m_trace; /**< the loaded trace */
+    bool m_streaming; /**< whether to install Ns2TraceMobilityModel */
+  };
+}
+
+#endif
@@ -0,0 +1,888 @@
+#include "ns2-binary-trace.h"
+#include "fcd-trace-scanner.h"
+#include "ns2-trace-scanner.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ns3
+{
+  namespace
+  {
+    const char kMagic[8] = { 'N', 'S', '2', 'T', 'R', 'A', 'C', 'E' };
+
+    /**
+     * Content hash of a trace file: FNV-1a over 64-bit words, so that it can
+     * run on every start at memory speed. Any edit changes it; it is not
+     * meant to resist deliberate collisions.
+     */
+    uint64_t
+    HashContents (const char *data, std::size_t size)
+    {
+      const uint64_t prime = 1099511628211ULL;
+      uint64_t hash = 14695981039346656037ULL ^ size;
+      std::size_t i = 0;
+      for (; i + sizeof (uint64_t) <= size; i += sizeof (uint64_t))
+	{
+	  uint64_t word;
+	  std::memcpy (&word, data + i, sizeof (word));
+	  hash = (hash ^ word) * prime;
+	  hash ^= hash >> 32;
+	}
+      for (; i < size; i++)
+	{
+	  hash = (hash ^ static_cast<uint8_t> (data[i])) * prime;
+	}
+      return hash;
+    }
+
+    Ns2BinaryTraceNode
+    EmptyNode ()
+    {
+      Ns2BinaryTraceNode node;
+      node.entryTime = -1;
+      node.exitTime = -1;
+      node.x = 0;
+      node.y = 0;
+      node.z = 0;
+      node.firstWaypoint = 0;
+      node.nWaypoints = 0;
+      return node;
+    }
+
+    Ns2BinaryTraceNode &
+    NodeSlot (std::vector<Ns2BinaryTraceNode> &nodes, uint32_t nodeId)
+    {
+      if (nodeId >= nodes.size ())
+	{
+	  nodes.resize (nodeId + 1, EmptyNode ());
+	}
+      return nodes[nodeId];
+    }
+
+    /**
+     * Folds one statement into the node index: initial positions, lifetime
+     * and number of waypoints.
+     */
+    void
+    IndexRecord (std::vector<Ns2BinaryTraceNode> &nodes, const Ns2TraceRecord &record)
+    {
+      Ns2BinaryTraceNode &node = NodeSlot (nodes, record.nodeId);
+      switch (record.kind)
+	{
+	case Ns2TraceRecord::SET_X:
+	  node.x = record.x;
+	  break;
+	case Ns2TraceRecord::SET_Y:
+	  node.y = record.x;
+	  break;
+	case Ns2TraceRecord::SET_Z:
+	  node.z = record.x;
+	  break;
+	case Ns2TraceRecord::SETDEST:
+	  node.nWaypoints++;
+	  // fall through
+	case Ns2TraceRecord::AT:
+	  if (node.entryTime < 0)
+	    {
+	      node.entryTime = record.time;
+	    }
+	  node.exitTime = record.time;
+	  break;
+	}
+    }
+
+    /**
+     * Assigns every node its slice of the columns and lays out the file.
+     * \return the header describing the layout
+     */
+    Ns2BinaryTraceHeader
+    LayOut (std::vector<Ns2BinaryTraceNode> &nodes)
+    {
+      Ns2BinaryTraceHeader header;
+      std::memset (&header, 0, sizeof (header));
+      std::memcpy (header.magic, kMagic, sizeof (kMagic));
+      header.version = Ns2BinaryTrace::VERSION;
+      header.nNodes = nodes.size ();
+      for (uint32_t i = 0; i < nodes.size (); i++)
+	{
+	  nodes[i].firstWaypoint = header.nWaypoints;
+	  header.nWaypoints += nodes[i].nWaypoints;
+	  header.simulationTime = std::max (header.simulationTime, nodes[i].exitTime);
+	}
+
+      uint64_t column = header.nWaypoints * sizeof (double);
+      header.nodeOffset = sizeof (header);
+      header.timeOffset = header.nodeOffset + nodes.size () * sizeof (Ns2BinaryTraceNode);
+      header.xOffset = header.timeOffset + column;
+      header.yOffset = header.xOffset + column;
+      header.speedOffset = header.yOffset + column;
+      return header;
+    }
+
+    struct ParsedWaypoint
+    {
+      uint32_t nodeId;
+      double time;
+      double x;
+      double y;
+      double speed;
+    };
+
+    /**
+     * Index and waypoints of one range of lines of a textual trace.
+     */
+    struct ParsedChunk
+    {
+      std::vector<Ns2BinaryTraceNode> nodes;  /**< index of the nodes seen in the range */
+      std::vector<uint8_t> positionSet;       /**< per node, bit k set if a SET_X + k record was seen */
+      std::vector<ParsedWaypoint> waypoints;  /**< setdest waypoints in file order */
+    };
+
+    template <typename Scanner>
+    void
+    ParseChunk (const char *begin, const char *end, ParsedChunk *chunk)
+    {
+      Scanner scanner (begin, end);
+      Ns2TraceRecord record;
+      while (scanner.Next (record))
+	{
+	  IndexRecord (chunk->nodes, record);
+	  if (record.kind == Ns2TraceRecord::SETDEST)
+	    {
+	      ParsedWaypoint w = { record.nodeId, record.time, record.x, record.y, record.speed };
+	      chunk->waypoints.push_back (w);
+	    }
+	  else if (record.kind != Ns2TraceRecord::AT)
+	    {
+	      if (record.nodeId >= chunk->positionSet.size ())
+		{
+		  chunk->positionSet.resize (record.nodeId + 1, 0);
+		}
+	      chunk->positionSet[record.nodeId] |= 1 << (record.kind - Ns2TraceRecord::SET_X);
+	    }
+	}
+    }
+
+    /**
+     * Copies the waypoints of a chunk into the columns, starting at the given
+     * per node cursors.
+     */
+    void
+    ScatterChunk (const ParsedChunk *chunk, std::vector<uint64_t> *cursor, double *times, uint64_t nWaypoints)
+    {
+      double *xs = times + nWaypoints;
+      double *ys = xs + nWaypoints;
+      double *speeds = ys + nWaypoints;
+      for (std::size_t i = 0; i < chunk->waypoints.size (); i++)
+	{
+	  const ParsedWaypoint &p = chunk->waypoints[i];
+	  uint64_t w = (*cursor)[p.nodeId]++;
+	  times[w] = p.time;
+	  xs[w] = p.x;
+	  ys[w] = p.y;
+	  speeds[w] = p.speed;
+	}
+    }
+
+    /**
+     * First pass of Compile: lifetimes, initial positions and waypoint counts per node.
+     */
+    template <typename Scanner>
+    void
+    IndexTrace (const char *begin, const char *end, std::vector<Ns2BinaryTraceNode> &nodes)
+    {
+      Scanner scanner (begin, end);
+      Ns2TraceRecord record;
+      while (scanner.Next (record))
+	{
+	  IndexRecord (nodes, record);
+	}
+    }
+
+    /**
+     * Second pass of Compile: scatters the waypoints into the columns of their node.
+     */
+    template <typename Scanner>
+    void
+    ScatterTrace (const char *begin, const char *end, std::vector<uint64_t> &cursor,
+		  double *times, double *xs, double *ys, double *speeds)
+    {
+      Scanner scanner (begin, end);
+      Ns2TraceRecord record;
+      while (scanner.Next (record))
+	{
+	  if (record.kind != Ns2TraceRecord::SETDEST)
+	    {
+	      continue;
+	    }
+	  uint64_t w = cursor[record.nodeId]++;
+	  times[w] = record.time;
+	  xs[w] = record.x;
+	  ys[w] = record.y;
+	  speeds[w] = record.speed;
+	}
+    }
+
+    /**
+     * Rebuilds the movement of a node under the setdest semantics of
+     * Ns2MobilityHelper: every waypoint heads from the current position
+     * towards its destination and the node stops once it gets there. The
+     * result has a vertex at every waypoint and at every arrival, with
+     * straight movement in between.
+     */
+    void
+    BuildTrack (const Ns2BinaryTraceNode &node, const double *times, const double *xs,
+		const double *ys, const double *speeds, std::vector<Ns2TrackVertex> &track)
+    {
+      track.clear ();
+      double x = node.x;
+      double y = node.y;
+      bool moving = false;
+      double startTime = 0;
+      double vx = 0;
+      double vy = 0;
+      double arrival = 0;
+      double destX = 0;
+      double destY = 0;
+      for (uint64_t w = 0; w < node.nWaypoints; w++)
+	{
+	  double at = times[w];
+	  if (moving)
+	    {
+	      if (arrival < at)
+		{
+		  Ns2TrackVertex stop = { arrival, destX, destY };
+		  track.push_back (stop);
+		  x = destX;
+		  y = destY;
+		}
+	      else
+		{
+		  x += vx * (at - startTime);
+		  y += vy * (at - startTime);
+		}
+	      moving = false;
+	    }
+	  Ns2TrackVertex vertex = { at, x, y };
+	  track.push_back (vertex);
+
+	  if (speeds[w] <= 0)
+	    {
+	      continue;
+	    }
+	  double dx = xs[w] - x;
+	  double dy = ys[w] - y;
+	  double time = std::sqrt (dx * dx + dy * dy) / speeds[w];
+	  if (time == 0)
+	    {
+	      continue;
+	    }
+	  moving = true;
+	  startTime = at;
+	  vx = dx / time;
+	  vy = dy / time;
+	  arrival = at + time;
+	  destX = xs[w];
+	  destY = ys[w];
+	}
+      if (moving)
+	{
+	  Ns2TrackVertex stop = { arrival, destX, destY };
+	  track.push_back (stop);
+	}
+    }
+
+    /**
+     * Checks whether moving straight from track[a] to track[b] at constant
+     * speed keeps the node within tolerance of every vertex in between at the
+     * same instant. Both movements are piecewise linear, so checking the
+     * vertices bounds the error at all times.
+     */
+    bool
+    FitsSegment (const std::vector<Ns2TrackVertex> &track, std::size_t a, std::size_t b, double tolerance)
+    {
+      double duration = track[b].time - track[a].time;
+      for (std::size_t k = a + 1; k < b; k++)
+	{
+	  double f = duration > 0 ? (track[k].time - track[a].time) / duration : 0;
+	  double dx = track[a].x + (track[b].x - track[a].x) * f - track[k].x;
+	  double dy = track[a].y + (track[b].y - track[a].y) * f - track[k].y;
+	  if (dx * dx + dy * dy > tolerance * tolerance)
+	    {
+	      return false;
+	    }
+	}
+      return duration > 0 || (track[a].x == track[b].x && track[a].y == track[b].y);
+    }
+  }
+
+  Ns2BinaryTrace::Ns2BinaryTrace ()
+    : m_file (0),
+      m_header (0),
+      m_nodes (0),
+      m_times (0),
+      m_x (0),
+      m_y (0),
+      m_speeds (0)
+  {
+  }
+
+  Ns2BinaryTrace::Ns2BinaryTrace (std::string file_name)
+    : m_file (new MappedFile (file_name)),
+      m_header (0),
+      m_nodes (0),
+      m_times (0),
+      m_x (0),
+      m_y (0),
+      m_speeds (0)
+  {
+    if (m_file->GetSize () < sizeof (Ns2BinaryTraceHeader))
+      {
+	return;
+      }
+
+    const char *data = m_file->GetData ();
+    const Ns2BinaryTraceHeader *header = reinterpret_cast<const Ns2BinaryTraceHeader *> (data);
+    if (std::memcmp (header->magic, kMagic, sizeof (kMagic)) != 0 || header->version != VERSION)
+      {
+	return;
+      }
+
+    uint64_t size = m_file->GetSize ();
+    uint64_t column = header->nWaypoints * sizeof (double);
+    if (header->nodeOffset + uint64_t (header->nNodes) * sizeof (Ns2BinaryTraceNode) > size
+	|| header->timeOffset + column > size
+	|| header->xOffset + column > size
+	|| header->yOffset + column > size
+	|| header->speedOffset + column > size)
+      {
+	return;
+      }
+
+    m_header = header;
+    m_nodes = reinterpret_cast<const Ns2BinaryTraceNode *> (data + header->nodeOffset);
+    m_times = reinterpret_cast<const double *> (data + header->timeOffset);
+    m_x = reinterpret_cast<const double *> (data + header->xOffset);
+    m_y = reinterpret_cast<const double *> (data + header->yOffset);
+    m_speeds = reinterpret_cast<const double *> (data + header->speedOffset);
+  }
+
+  Ns2BinaryTrace::~Ns2BinaryTrace ()
+  {
+    delete m_file;
+  }
+
+  Ptr<Ns2BinaryTrace>
+  Ns2BinaryTrace::Load (std::string file_name, uint32_t parseThreads)
+  {
+    if (IsBinaryTrace (file_name))
+      {
+	Ptr<Ns2BinaryTrace> trace = Create<Ns2BinaryTrace> (file_name);
+	if (!trace->IsValid ())
+	  {
+	    return 0;
+	  }
+	return trace;
+      }
+
+    MappedFile file (file_name);
+    if (!file.IsOpen ())
+      {
+	return 0;
+      }
+    Ptr<Ns2BinaryTrace> trace = Ptr<Ns2BinaryTrace> (new Ns2BinaryTrace (), false);
+    trace->Parse (file.GetData (), file.GetSize (), std::max (parseThreads, 1u));
+    return trace;
+  }
+
+  Ptr<Ns2BinaryTrace>
+  Ns2BinaryTrace::LoadCached (std::string file_name, uint32_t parseThreads)
+  {
+    if (IsBinaryTrace (file_name))
+      {
+	return Load (file_name, parseThreads);
+      }
+
+    MappedFile file (file_name);
+    if (!file.IsOpen ())
+      {
+	return 0;
+      }
+    uint64_t hash = HashContents (file.GetData (), file.GetSize ());
+
+    std::string cache_file_name = file_name + ".cache";
+    Ptr<Ns2BinaryTrace> cached = Create<Ns2BinaryTrace> (cache_file_name);
+    if (cached->IsValid () && cached->m_header->sourceSize == file.GetSize ()
+	&& cached->m_header->sourceHash == hash)
+      {
+	return cached;
+      }
+
+    // FCD is read on one thread either way, so it is compiled straight into
+    // the sidecar and mapped instead of holding every waypoint in memory.
+    if (FcdTraceScanner::IsFcdTrace (file.GetData (), file.GetData () + file.GetSize ())
+	&& Compile (file_name, cache_file_name))
+      {
+	Ptr<Ns2BinaryTrace> compiled = Create<Ns2BinaryTrace> (cache_file_name);
+	if (compiled->IsValid ())
+	  {
+	    return compiled;
+	  }
+      }
+
+    Ptr<Ns2BinaryTrace> trace = Ptr<Ns2BinaryTrace> (new Ns2BinaryTrace (), false);
+    trace->Parse (file.GetData (), file.GetSize (), std::max (parseThreads, 1u));
+    trace->m_ownedHeader.sourceSize = file.GetSize ();
+    trace->m_ownedHeader.sourceHash = hash;
+    trace->Write (cache_file_name);
+    return trace;
+  }
+
+  void
+  Ns2BinaryTrace::Parse (const char *data, std::size_t size, uint32_t parseThreads)
+  {
+    // Every range of lines is indexed on its own thread, collecting its
+    // waypoints in file order. The indices are then merged in file order and
+    // each range scatters its waypoints into the columns of their node.
+    // SUMO FCD output is read in one piece, since its node ids depend on the
+    // order in which vehicles first appear.
+    std::vector<const char *> bounds;
+    bool fcd = FcdTraceScanner::IsFcdTrace (data, data + size);
+    if (fcd)
+      {
+	bounds.push_back (data);
+	bounds.push_back (data + size);
+      }
+    else
+      {
+	bounds = Ns2TraceScanner::SplitLines (data, data + size, parseThreads);
+      }
+    uint32_t nChunks = bounds.size () - 1;
+    std::vector<ParsedChunk> chunks (nChunks);
+
+    std::vector<std::thread> workers;
+    for (uint32_t c = 1; c < nChunks; c++)
+      {
+	workers.push_back (std::thread (ParseChunk<Ns2TraceScanner>, bounds[c], bounds[c + 1], &chunks[c]));
+      }
+    if (fcd)
+      {
+	ParseChunk<FcdTraceScanner> (bounds[0], bounds[1], &chunks[0]);
+      }
+    else
+      {
+	ParseChunk<Ns2TraceScanner> (bounds[0], bounds[1], &chunks[0]);
+      }
+    for (uint32_t i = 0; i < workers.size (); i++)
+      {
+	workers[i].join ();
+      }
+
+    for (uint32_t c = 0; c < nChunks; c++)
+      {
+	const ParsedChunk &chunk = chunks[c];
+	if (chunk.nodes.size () > m_ownedNodes.size ())
+	  {
+	    m_ownedNodes.resize (chunk.nodes.size (), EmptyNode ());
+	  }
+	for (uint32_t i = 0; i < chunk.nodes.size (); i++)
+	  {
+	    const Ns2BinaryTraceNode &local = chunk.nodes[i];
+	    Ns2BinaryTraceNode &node = m_ownedNodes[i];
+	    uint8_t set = i < chunk.positionSet.size () ? chunk.positionSet[i] : 0;
+	    if (set & 1)
+	      {
+		node.x = local.x;
+	      }
+	    if (set & 2)
+	      {
+		node.y = local.y;
+	      }
+	    if (set & 4)
+	      {
+		node.z = local.z;
+	      }
+	    if (local.entryTime >= 0)
+	      {
+		if (node.entryTime < 0)
+		  {
+		    node.entryTime = local.entryTime;
+		  }
+		node.exitTime = local.exitTime;
+	      }
+	    node.nWaypoints += local.nWaypoints;
+	  }
+      }
+
+    m_ownedHeader = LayOut (m_ownedNodes);
+    uint64_t n = m_ownedHeader.nWaypoints;
+    m_ownedColumns.resize (4 * n);
+    double *times = m_ownedColumns.empty () ? 0 : &m_ownedColumns[0];
+
+    // Each range starts writing where the waypoints of the previous ranges
+    // end, so the ranges fill disjoint slots and can run concurrently.
+    std::vector<std::vector<uint64_t> > cursors (nChunks, std::vector<uint64_t> (m_ownedNodes.size ()));
+    for (uint32_t i = 0; i < m_ownedNodes.size (); i++)
+      {
+	uint64_t cursor = m_ownedNodes[i].firstWaypoint;
+	for (uint32_t c = 0; c < nChunks; c++)
+	  {
+	    cursors[c][i] = cursor;
+	    cursor += i < chunks[c].nodes.size () ? chunks[c].nodes[i].nWaypoints : 0;
+	  }
+      }
+
+    workers.clear ();
+    for (uint32_t c = 1; c < nChunks; c++)
+      {
+	workers.push_back (std::thread (ScatterChunk, &chunks[c], &cursors[c], times, n));
+      }
+    ScatterChunk (&chunks[0], &cursors[0], times, n);
+    for (uint32_t i = 0; i < workers.size (); i++)
+      {
+	workers[i].join ();
+      }
+
+    m_header = &m_ownedHeader;
+    m_nodes = m_ownedNodes.empty () ? 0 : &m_ownedNodes[0];
+    m_times = times;
+    m_x = times + n;
+    m_y = times + 2 * n;
+    m_speeds = times + 3 * n;
+  }
+
+  bool
+  Ns2BinaryTrace::IsBinaryTrace (std::string file_name)
+  {
+    char magic[sizeof (kMagic)];
+    std::ifstream input (file_name.c_str (), std::ios::binary);
+    if (!input.read (magic, sizeof (magic)))
+      {
+	return false;
+      }
+    return std::memcmp (magic, kMagic, sizeof (kMagic)) == 0;
+  }
+
+  bool
+  Ns2BinaryTrace::Compile (std::string ns2_file_name, std::string binary_file_name)
+  {
+    MappedFile input (ns2_file_name);
+    if (!input.IsOpen ())
+      {
+	return false;
+      }
+    const char *begin = input.GetData ();
+    const char *end = begin + input.GetSize ();
+
+    // Two passes over the input: the index first, then the waypoints go
+    // straight into the mapped output, so memory does not grow with the trace.
+    bool fcd = FcdTraceScanner::IsFcdTrace (begin, end);
+    std::vector<Ns2BinaryTraceNode> nodes;
+    if (fcd)
+      {
+	IndexTrace<FcdTraceScanner> (begin, end, nodes);
+      }
+    else
+      {
+	IndexTrace<Ns2TraceScanner> (begin, end, nodes);
+      }
+
+    Ns2BinaryTraceHeader header = LayOut (nodes);
+    header.sourceSize = input.GetSize ();
+    header.sourceHash = HashContents (begin, input.GetSize ());
+    uint64_t column = header.nWaypoints * sizeof (double);
+    uint64_t size = header.speedOffset + column;
+
+    std::string tmp_file_name = binary_file_name + ".tmp." + std::to_string (getpid ());
+    int fd = open (tmp_file_name.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      {
+	return false;
+      }
+    if (ftruncate (fd, size) != 0)
+      {
+	close (fd);
+	unlink (tmp_file_name.c_str ());
+	return false;
+      }
+    void *addr = mmap (0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (addr == MAP_FAILED)
+      {
+	unlink (tmp_file_name.c_str ());
+	return false;
+      }
+
+    char *out = static_cast<char *> (addr);
+    std::memcpy (out, &header, sizeof (header));
+    if (!nodes.empty ())
+      {
+	std::memcpy (out + header.nodeOffset, &nodes[0], nodes.size () * sizeof (Ns2BinaryTraceNode));
+      }
+    double *times = reinterpret_cast<double *> (out + header.timeOffset);
+    double *xs = reinterpret_cast<double *> (out + header.xOffset);
+    double *ys = reinterpret_cast<double *> (out + header.yOffset);
+    double *speeds = reinterpret_cast<double *> (out + header.speedOffset);
+
+    std::vector<uint64_t> cursor (nodes.size ());
+    for (uint32_t i = 0; i < nodes.size (); i++)
+      {
+	cursor[i] = nodes[i].firstWaypoint;
+      }
+    if (fcd)
+      {
+	ScatterTrace<FcdTraceScanner> (begin, end, cursor, times, xs, ys, speeds);
+      }
+    else
+      {
+	ScatterTrace<Ns2TraceScanner> (begin, end, cursor, times, xs, ys, speeds);
+      }
+
+    bool ok = msync (addr, size, MS_SYNC) == 0;
+    munmap (addr, size);
+    if (!ok || std::rename (tmp_file_name.c_str (), binary_file_name.c_str ()) != 0)
+      {
+	unlink (tmp_file_name.c_str ());
+	return false;
+      }
+    return true;
+  }
+
+  Ptr<Ns2BinaryTrace>
+  Ns2BinaryTrace::Simplify (Ptr<Ns2BinaryTrace> trace, double tolerance)
+  {
+    std::vector<Ns2BinaryTraceNode> nodes (trace->m_nodes, trace->m_nodes + trace->GetNNodes ());
+
+    // The simplified columns are built one after the other and laid out
+    // once the number of waypoints per node is known.
+    std::vector<double> times;
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> speeds;
+    std::vector<Ns2TrackVertex> track;
+    for (uint32_t i = 0; i < trace->GetNNodes (); i++)
+      {
+	Ns2BinaryTraceNode &node = nodes[i];
+	trace->GetTrack (i, track);
+	node.nWaypoints = 0;
+	if (track.empty ())
+	  {
+	    continue;
+	  }
+
+	// Opening window: stretch each segment as long as it stays within
+	// tolerance of the original movement, then start the next one there.
+	std::size_t anchor = 0;
+	while (true)
+	  {
+	    std::size_t end = anchor + 1;
+	    while (end + 1 < track.size () && FitsSegment (track, anchor, end + 1, tolerance))
+	      {
+		end++;
+	      }
+
+	    const Ns2TrackVertex &from = track[anchor];
+	    if (end >= track.size ())
+	      {
+		// Last vertex: the node rests there. Keep a waypoint only if the
+		// node had none, so that it still appears in the columns.
+		if (node.nWaypoints == 0)
+		  {
+		    times.push_back (from.time);
+		    xs.push_back (from.x);
+		    ys.push_back (from.y);
+		    speeds.push_back (0);
+		    node.nWaypoints++;
+		  }
+		break;
+	      }
+	    const Ns2TrackVertex &to = track[end];
+	    double dx = to.x - from.x;
+	    double dy = to.y - from.y;
+	    double duration = to.time - from.time;
+	    double distance = std::sqrt (dx * dx + dy * dy);
+	    times.push_back (from.time);
+	    xs.push_back (to.x);
+	    ys.push_back (to.y);
+	    speeds.push_back (distance > 0 && duration > 0 ? distance / duration : 0);
+	    node.nWaypoints++;
+	    anchor = end;
+	  }
+      }
+
+    return FromColumns (nodes, times, xs, ys, speeds);
+  }
+
+  Ptr<Ns2BinaryTrace>
+  Ns2BinaryTrace::FromColumns (const std::vector<Ns2BinaryTraceNode> &nodes, const std::vector<double> &times,
+			       const std::vector<double> &xs, const std::vector<double> &ys,
+			       const std::vector<double> &speeds)
+  {
+    Ptr<Ns2BinaryTrace> result = Ptr<Ns2BinaryTrace> (new Ns2BinaryTrace (), false);
+    result->m_ownedNodes = nodes;
+    result->m_ownedHeader = LayOut (result->m_ownedNodes);
+    uint64_t n = result->m_ownedHeader.nWaypoints;
+    NS_ASSERT (times.size () == n && xs.size () == n && ys.size () == n && speeds.size () == n);
+    result->m_ownedColumns.reserve (4 * n);
+    result->m_ownedColumns.insert (result->m_ownedColumns.end (), times.begin (), times.end ());
+    result->m_ownedColumns.insert (result->m_ownedColumns.end (), xs.begin (), xs.end ());
+    result->m_ownedColumns.insert (result->m_ownedColumns.end (), ys.begin (), ys.end ());
+    result->m_ownedColumns.insert (result->m_ownedColumns.end (), speeds.begin (), speeds.end ());
+
+    const double *columns = result->m_ownedColumns.empty () ? 0 : &result->m_ownedColumns[0];
+    result->m_header = &result->m_ownedHeader;
+    result->m_nodes = result->m_ownedNodes.empty () ? 0 : &result->m_ownedNodes[0];
+    result->m_times = columns;
+    result->m_x = columns + n;
+    result->m_y = columns + 2 * n;
+    result->m_speeds = columns + 3 * n;
+    return result;
+  }
+
+  bool
+  Ns2BinaryTrace::Write (std::string binary_file_name) const
+  {
+    if (!IsValid ())
+      {
+	return false;
+      }
+
+    std::string tmp_file_name = binary_file_name + ".tmp." + std::to_string (getpid ());
+    std::ofstream output (tmp_file_name.c_str (), std::ios::binary | std::ios::trunc);
+    uint64_t column = m_header->nWaypoints * sizeof (double);
+    Ns2BinaryTraceHeader header = *m_header;
+    header.nodeOffset = sizeof (header);
+    header.timeOffset = header.nodeOffset + uint64_t (header.nNodes) * sizeof (Ns2BinaryTraceNode);
+    header.xOffset = header.timeOffset + column;
+    header.yOffset = header.xOffset + column;
+    header.speedOffset = header.yOffset + column;
+
+    output.write (reinterpret_cast<const char *> (&header), sizeof (header));
+    output.write (reinterpret_cast<const char *> (m_nodes), uint64_t (header.nNodes) * sizeof (Ns2BinaryTraceNode));
+    output.write (reinterpret_cast<const char *> (m_times), column);
+    output.write (reinterpret_cast<const char *> (m_x), column);
+    output.write (reinterpret_cast<const char *> (m_y), column);
+    output.write (reinterpret_cast<const char *> (m_speeds), column);
+    output.close ();
+    if (!output || std::rename (tmp_file_name.c_str (), binary_file_name.c_str ()) != 0)
+      {
+	unlink (tmp_file_name.c_str ());
+	return false;
+      }
+    return true;
+  }
+
+  void
+  Ns2BinaryTrace::GetTrack (uint32_t nodeId, std::vector<Ns2TrackVertex> &track) const
+  {
+    const Ns2BinaryTraceNode &node = GetNode (nodeId);
+    uint64_t first = node.firstWaypoint;
+    BuildTrack (node, m_times + first, m_x + first, m_y + first, m_speeds + first, track);
+  }
+
+  bool
+  Ns2BinaryTrace::IsValid () const
+  {
+    return m_header != 0;
+  }
+
+  uint32_t
+  Ns2BinaryTrace::GetNNodes () const
+  {
+    return m_header ? m_header->nNodes : 0;
+  }
+
+  uint64_t
+  Ns2BinaryTrace::GetNWaypoints () const
+  {
+    return m_header ? m_header->nWaypoints : 0;
+  }
+
+  double
+  Ns2BinaryTrace::GetSimulationTime () const
+  {
+    return m_header ? m_header->simulationTime : 0;
+  }
+
+  const Ns2BinaryTraceNode &
+  Ns2BinaryTrace::GetNode (uint32_t nodeId) const
+  {
+    NS_ASSERT (nodeId < GetNNodes ());
+    return m_nodes[nodeId];
+  }
+
+  Vector
+  Ns2BinaryTrace::GetInitialPosition (uint32_t nodeId) const
+  {
+    const Ns2BinaryTraceNode &node = GetNode (nodeId);
+    return Vector (node.x, node.y, node.z);
+  }
+
+  uint64_t
+  Ns2BinaryTrace::GetNMobilityEvents () const
+  {
+    uint64_t events = 0;
+    for (uint64_t w = 0; w < GetNWaypoints (); w++)
+      {
+	if (m_speeds[w] == 0)
+	  {
+	    events++;
+	  }
+	else if (m_speeds[w] > 0)
+	  {
+	    events += 2;
+	  }
+      }
+    return events;
+  }
+
+  const double *
+  Ns2BinaryTrace::GetTimes () const
+  {
+    return m_times;
+  }
+
+  const double *
+  Ns2BinaryTrace::GetX () const
+  {
+    return m_x;
+  }
+
+  const double *
+  Ns2BinaryTrace::GetY () const
+  {
+    return m_y;
+  }
+
+  const double *
+  Ns2BinaryTrace::GetSpeeds () const
+  {
+    return m_speeds;
+  }
+
+  void
+  Ns2BinaryTrace::Release (uint64_t first, uint64_t n) const
+  {
+    if (m_file == 0)
+      {
+	return;
+      }
+    uint64_t offsets[] = { m_header->timeOffset, m_header->xOffset, m_header->yOffset, m_header->speedOffset };
+    for (uint32_t c = 0; c < 4; c++)
+      {
+	m_file->Release (offsets[c] + first * sizeof (double), n * sizeof (double));
+      }
+  }
+}
@@ -0,0 +1,247 @@
+#ifndef SUMOTRACEEXAMPLE_NS2_BINARY_TRACE_H_
+#define SUMOTRACEEXAMPLE_NS2_BINARY_TRACE_H_
+
+#include "mapped-file.h"
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/vector.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+  /**
+   * File header of a compiled ns-2 mobility trace. All fields are in host
+   * byte order; the file is meant to be produced and consumed on the same
+   * machine. Offsets are in bytes from the start of the file.
+   */
+  struct Ns2BinaryTraceHeader
+  {
+    char magic[8];          /**< "NS2TRACE" */
+    uint32_t version;       /**< Ns2BinaryTrace::VERSION */
+    uint32_t nNodes;        /**< number of node slots, i.e. highest node id + 1 */
+    uint64_t nWaypoints;    /**< total number of setdest waypoints */
+    double simulationTime;  /**< latest exit time over all nodes */
+    uint64_t nodeOffset;    /**< offset of the Ns2BinaryTraceNode table (index) */
+    uint64_t timeOffset;    /**< offset of the waypoint time column */
+    uint64_t xOffset;       /**< offset of the waypoint x column */
+    uint64_t yOffset;       /**< offset of the waypoint y column */
+    uint64_t speedOffset;   /**< offset of the waypoint speed column */
+    uint64_t sourceSize;    /**< size in bytes of the trace this was compiled from */
+    uint64_t sourceHash;    /**< content hash of the trace this was compiled from */
+  };
+
+  /**
+   * Per node entry of the index that follows the header. The waypoints of a
+   * node are stored contiguously, in file order, in each of the columns.
+   */
+  struct Ns2BinaryTraceNode
+  {
+    double entryTime;       /**< first "$ns_ at" time of the node, negative if the id is not in the trace */
+    double exitTime;        /**< last "$ns_ at" time of the node */
+    double x;               /**< initial position set with "set X_" */
+    double y;               /**< initial position set with "set Y_" */
+    double z;               /**< initial position set with "set Z_" */
+    uint64_t firstWaypoint; /**< index of the first waypoint of this node in the columns */
+    uint64_t nWaypoints;    /**< number of waypoints of this node */
+  };
+
+  /**
+   * Position of a node at a given time. A node moves in a straight line at
+   * constant speed between consecutive vertices of its track.
+   */
+  struct Ns2TrackVertex
+  {
+    double time;
+    double x;
+    double y;
+  };
+
+  /**
+   * Compiled, memory-mapped ns-2 mobility trace.
+   *
+   * The textual "$ns_ at ... setdest" script is converted once by Compile()
+   * into a header, a node index with entry/exit times and initial positions,
+   * and one column per waypoint attribute. Opening a compiled trace only maps
+   * it, so the cost of loading is independent of its size and the pages are
+   * shared through the page cache by every process using the same file.
+   *
+   * Textual traces can also be loaded in the same layout with Load(), which
+   * parses them once in memory. Both Load() and Compile() also accept the FCD
+   * XML written by sumo --fcd-output, read as the ns-2 script traceExporter.py
+   * would produce from it (see FcdTraceScanner). The result then serves both the node
+   * lifetimes (Ns2NodeUtility) and the mobility installation
+   * (Ns2BinaryMobilityHelper) without reading the file a second time.
+   */
+  class Ns2BinaryTrace : public SimpleRefCount<Ns2BinaryTrace>
+  {
+  public:
+    static const uint32_t VERSION = 2;
+
+    /**
+     * Maps a compiled trace. Use IsValid() to check the result.
+     * \param file_name of the compiled trace
+     */
+    Ns2BinaryTrace (std::string file_name);
+    ~Ns2BinaryTrace ();
+    /**
+     * Loads a mobility trace in any format: compiled traces are mapped,
+     * ns-2 scripts and SUMO FCD exports are parsed in a single pass over the
+     * file. A parsed trace holds all of its waypoints in memory, so
+     * Ns2TraceMobilityModel can not bound memory with it; use a compiled
+     * trace or LoadCached() for that.
+     * \param file_name of the trace
+     * \param parseThreads number of threads scanning an ns-2 script, each on its own range of lines
+     * \return the loaded trace, empty if the file can not be read
+     */
+    static Ptr<Ns2BinaryTrace> Load (std::string file_name, uint32_t parseThreads = 1);
+    /**
+     * Like Load(), but keeps the parsed trace in a compiled sidecar file
+     * (file_name + ".cache") for later runs. The sidecar records the format
+     * version and the size and content hash of the trace; when they still
+     * match it is mapped instead of parsing the trace, otherwise the trace is
+     * parsed and the sidecar rewritten. An FCD export is compiled into the
+     * sidecar directly and mapped, so its waypoints are never all in memory.
+     * Failing to write the sidecar, e.g. in a read-only directory, only costs
+     * the next run a parse.
+     * \param file_name of the trace
+     * \param parseThreads number of threads scanning an ns-2 script
+     * \return the loaded trace, empty if the file can not be read
+     */
+    static Ptr<Ns2BinaryTrace> LoadCached (std::string file_name, uint32_t parseThreads = 1);
+    /**
+     * \param file_name of a mobility trace
+     * \return true if the file starts with the magic of a compiled trace
+     */
+    static bool IsBinaryTrace (std::string file_name);
+    /**
+     * Converts an ns-2 mobility script or a SUMO FCD export into the compiled format. The
+     * output is written to a temporary file that is renamed into place, so
+     * concurrent readers never observe a partial file.
+     * \param ns2_file_name of the ns-2 script or FCD export
+     * \param binary_file_name of the compiled trace to write
+     * \return false if the input can not be read or the output can not be written
+     */
+    static bool Compile (std::string ns2_file_name, std::string binary_file_name);
+    /**
+     * Merges waypoints that keep a node on the same straight line at the same
+     * speed. The movement each node actually follows under the setdest
+     * semantics is rebuilt as a polyline over time, reduced so that at every
+     * instant the simplified position stays within tolerance of the original
+     * one, and written back as one setdest per remaining segment. Node
+     * lifetimes are left untouched.
+     * \param trace to simplify
+     * \param tolerance maximum distance in meters between the original and the simplified position of a node
+     * \return a new trace held in memory
+     */
+    static Ptr<Ns2BinaryTrace> Simplify (Ptr<Ns2BinaryTrace> trace, double tolerance);
+    /**
+     * Builds a trace in memory from waypoint columns that are already grouped
+     * by node, e.g. by a trace generator.
+     * \param nodes index of the trace; only entryTime, exitTime, the initial
+     * position and nWaypoints are used, firstWaypoint is recomputed
+     * \param times waypoint times, the waypoints of node 0 first, then node 1 and so on
+     * \param xs waypoint destination x, in the same order
+     * \param ys waypoint destination y, in the same order
+     * \param speeds waypoint speeds, in the same order
+     * \return a new trace held in memory
+     */
+    static Ptr<Ns2BinaryTrace> FromColumns (const std::vector<Ns2BinaryTraceNode> &nodes,
+					    const std::vector<double> &times, const std::vector<double> &xs,
+					    const std::vector<double> &ys, const std::vector<double> &speeds);
+    /**
+     * Writes the trace in the compiled format, through a temporary file that
+     * is renamed into place.
+     * \param binary_file_name of the compiled trace to write
+     * \return false if the file can not be written
+     */
+    bool Write (std::string binary_file_name) const;
+
+    /**
+     * \return true if the file was mapped and its header and index are consistent
+     */
+    bool IsValid () const;
+    /**
+     * \return the number of node slots (highest node id + 1)
+     */
+    uint32_t GetNNodes () const;
+    /**
+     * \return the total number of waypoints
+     */
+    uint64_t GetNWaypoints () const;
+    /**
+     * \return the latest exit time over all nodes in seconds
+     */
+    double GetSimulationTime () const;
+    /**
+     * \param nodeId of the node
+     * \return the index entry of the node
+     */
+    const Ns2BinaryTraceNode &GetNode (uint32_t nodeId) const;
+    /**
+     * \param nodeId of the node
+     * \return the initial position of the node
+     */
+    Vector GetInitialPosition (uint32_t nodeId) const;
+    /**
+     * \return the number of simulator events Ns2BinaryMobilityHelper schedules
+     * for the trace: one for every stop and two for every movement
+     */
+    uint64_t GetNMobilityEvents () const;
+    /**
+     * Rebuilds the movement of a node under the setdest semantics of
+     * Ns2MobilityHelper: every waypoint heads from the current position
+     * towards its destination and the node stops once it gets there.
+     * \param nodeId of the node
+     * \param track filled in with a vertex at every waypoint and at every arrival
+     */
+    void GetTrack (uint32_t nodeId, std::vector<Ns2TrackVertex> &track) const;
+    /** \return the waypoint time column */
+    const double *GetTimes () const;
+    /** \return the waypoint destination x column */
+    const double *GetX () const;
+    /** \return the waypoint destination y column */
+    const double *GetY () const;
+    /** \return the waypoint speed column */
+    const double *GetSpeeds () const;
+    /**
+     * Tells the trace that waypoints will not be read again. For a compiled
+     * trace the pages holding them are dropped from the mapping, so resident
+     * memory only covers what is being read; they are read back from the
+     * page cache if needed. A trace parsed in memory keeps them.
+     * \param first index of the first waypoint
+     * \param n number of waypoints
+     */
+    void Release (uint64_t first, uint64_t n) const;
+
+  private:
+    Ns2BinaryTrace ();
+    Ns2BinaryTrace (const Ns2BinaryTrace &);
+    Ns2BinaryTrace &operator= (const Ns2BinaryTrace &);
+
+    /**
+     * Builds the compiled layout in memory from one pass over a textual trace.
+     * \param data of the textual trace
+     * \param size of the textual trace in bytes
+     * \param parseThreads number of line ranges scanned concurrently
+     */
+    void Parse (const char *data, std::size_t size, uint32_t parseThreads);
+
+    MappedFile *m_file; /**< mapping of the compiled trace, 0 for traces parsed in memory */
+    const Ns2BinaryTraceHeader *m_header; /**< header, 0 if the trace is not valid */
+    const Ns2BinaryTraceNode *m_nodes; /**< node index */
+    const double *m_times; /**< waypoint time column */
+    const double *m_x; /**< waypoint x column */
+    const double *m_y; /**< waypoint y column */
+    const double *m_speeds; /**< waypoint speed column */
+
+    Ns2BinaryTraceHeader m_ownedHeader; /**< header of a trace parsed in memory */
+    std::vector<Ns2BinaryTraceNode> m_ownedNodes; /**< index of a trace parsed in memory */
+    std::vector<double> m_ownedColumns; /**< the four columns of a trace parsed in memory, back to back */
+  };
+}
+
+#endif
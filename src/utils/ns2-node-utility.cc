@@ -1,58 +1,186 @@
 #include "ns2-node-utility.h"
-#include <regex>
+#include "fcd-trace-scanner.h"
+#include "mapped-file.h"
+#include "ns2-binary-trace.h"
+#include "ns2-trace-scanner.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <thread>
 
 namespace ns3
 {
-  Ns2NodeUtility::Ns2NodeUtility (std::string name)
+  namespace
+  {
+    /**
+     * Records the first and last "$ns_ at" time stamp of every node found in
+     * a range of the trace, indexed by node id (negative for absent ids).
+     */
+    template <typename Scanner>
+    void
+    ScanLifetimes (const char *begin, const char *end, std::vector<std::pair<double, double> > *table)
+    {
+      Scanner scanner (begin, end);
+      Ns2TraceRecord record;
+      while (scanner.Next (record))
+	{
+	  if (record.kind != Ns2TraceRecord::SETDEST && record.kind != Ns2TraceRecord::AT)
+	    {
+	      continue;
+	    }
+	  if (record.nodeId >= table->size ())
+	    {
+	      table->resize (record.nodeId + 1, std::make_pair (-1.0, -1.0));
+	    }
+	  std::pair<double, double> &times = (*table)[record.nodeId];
+	  if (times.first < 0)
+	    {
+	      times.first = record.time;
+	    }
+	  times.second = record.time;
+	}
+    }
+  }
+
+  Ns2NodeUtility::Ns2NodeUtility (std::string name, uint32_t parseThreads)
   {
     m_file_name = name;
-    m_input_file.open(m_file_name);
+    m_n_nodes = 0;
 
-    std::string line;
+    if (Ns2BinaryTrace::IsBinaryTrace (m_file_name))
+      {
+	Ns2BinaryTrace trace (m_file_name);
+	AddTrace (trace);
+	return;
+      }
+
+    MappedFile file (m_file_name);
+    if (FcdTraceScanner::IsFcdTrace (file.GetData (), file.GetData () + file.GetSize ()))
+      {
+	// SUMO FCD output is read directly. Node ids depend on the order in
+	// which vehicles first appear, so it is always read in one piece.
+	std::vector<std::pair<double, double> > table;
+	ScanLifetimes<FcdTraceScanner> (file.GetData (), file.GetData () + file.GetSize (), &table);
+	AddLifetimes (table);
+	return;
+      }
+    if (parseThreads > 1)
+      {
+	ParseParallel (file.GetData (), file.GetData () + file.GetSize (), parseThreads);
+	return;
+      }
 
-    std::vector <uint32_t> node_ids;
+    Ns2TraceScanner scanner (file.GetData (), file.GetData () + file.GetSize ());
+    Ns2TraceRecord record;
 
-    while (std::getline (m_input_file, line))
+    // Single pass over the mapped file: every "$ns_ at" statement widens the
+    // lifetime of its node, and the table is indexed directly by node id.
+    while (scanner.Next (record))
       {
-	std::smatch sm;
-	std::regex r("\\$ns_ at (\\d*.\\d) \"\\$node_\\((\\d*)\\)");
-	if (std::regex_search(line, sm, r))
+	if (record.kind != Ns2TraceRecord::SETDEST && record.kind != Ns2TraceRecord::AT)
 	  {
-	    //std::cout << "MATCH!" << std::endl;
-
-	    uint32_t id = std::stoi(sm[2]);
-	    double new_latest = std::stof(sm[1]);
-
-	    if ( std::find (node_ids.begin(), node_ids.end(), id) != node_ids.end())
-	      {
-		double entry_time = std::get<0> (m_node_times [id]);
-		m_node_times [id] = std::make_pair(entry_time, new_latest);
-	      }
-	    else
-	      {
-		m_node_times [id] = std::make_pair(new_latest, new_latest);
-	      }
-	    node_ids.push_back(id);
+	    continue;
 	  }
-	else
+	AddTime (record.nodeId, record.time);
+      }
+  }
+  void
+  Ns2NodeUtility::ParseParallel (const char *begin, const char *end, uint32_t parseThreads)
+  {
+    std::vector<const char *> bounds = Ns2TraceScanner::SplitLines (begin, end, parseThreads);
+    uint32_t n = bounds.size () - 1;
+    std::vector<std::vector<std::pair<double, double> > > tables (n);
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < n; i++)
+      {
+	workers.push_back (std::thread (ScanLifetimes<Ns2TraceScanner>, bounds[i], bounds[i + 1], &tables[i]));
+      }
+    ScanLifetimes<Ns2TraceScanner> (bounds[0], bounds[1], &tables[0]);
+    for (uint32_t i = 0; i < workers.size (); i++)
+      {
+	workers[i].join ();
+      }
+
+    // Merging the tables in file order keeps the entry time of the first
+    // piece and the exit time of the last piece a node appears in, which is
+    // exactly what the serial scan records.
+    for (uint32_t i = 0; i < n; i++)
+      {
+	AddLifetimes (tables[i]);
+      }
+  }
+  void
+  Ns2NodeUtility::AddLifetimes (const std::vector<std::pair<double, double> > &table)
+  {
+    for (uint32_t id = 0; id < table.size (); id++)
+      {
+	if (table[id].first >= 0)
 	  {
-	    //std::cout << "No Match!" << std::endl;
+	    AddTime (id, table[id].first);
+	    AddTime (id, table[id].second);
 	  }
       }
   }
+  Ns2NodeUtility::Ns2NodeUtility (Ptr<Ns2BinaryTrace> trace)
+  {
+    m_n_nodes = 0;
+    if (trace != 0)
+      {
+	AddTrace (*trace);
+      }
+  }
+  void
+  Ns2NodeUtility::AddTrace (const Ns2BinaryTrace &trace)
+  {
+    // Compiled traces already carry the lifetime of every node in their index.
+    for (uint32_t i = 0; i < trace.GetNNodes (); i++)
+      {
+	const Ns2BinaryTraceNode &node = trace.GetNode (i);
+	if (node.entryTime >= 0)
+	  {
+	    AddTime (i, node.entryTime);
+	    AddTime (i, node.exitTime);
+	  }
+      }
+  }
+  void
+  Ns2NodeUtility::AddTime (uint32_t nodeId, double time)
+  {
+    if (nodeId >= m_node_times.size ())
+      {
+	m_node_times.resize (nodeId + 1, std::make_pair (-1.0, -1.0));
+      }
+
+    std::pair<double, double> &times = m_node_times[nodeId];
+    if (times.first < 0)
+      {
+	times = std::make_pair (time, time);
+	m_n_nodes++;
+      }
+    else
+      {
+	times.second = time;
+      }
+  }
   uint32_t
   Ns2NodeUtility::GetNNodes ()
   {
-    return m_node_times.size();
+    return m_n_nodes;
   }
   double
   Ns2NodeUtility::GetEntryTimeForNode (uint32_t nodeId)
   {
+    if (nodeId >= m_node_times.size () || m_node_times[nodeId].first < 0)
+      return 0;
     return std::get<0>(m_node_times [nodeId]);
   }
   double
   Ns2NodeUtility::GetExitTimeForNode (uint32_t nodeId)
   {
+    if (nodeId >= m_node_times.size () || m_node_times[nodeId].first < 0)
+      return 0;
     return std::get<1>(m_node_times [nodeId]);
   }
   double
@@ -66,6 +194,59 @@ namespace ns3
     return time;
   }
 
+  uint32_t
+  Ns2NodeUtility::AssignSlots ()
+  {
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < m_node_times.size (); i++)
+      {
+	if (m_node_times[i].first >= 0)
+	  {
+	    order.push_back (i);
+	  }
+      }
+    const std::vector<std::pair<double, double> > &times = m_node_times;
+    std::stable_sort (order.begin (), order.end (), [&times] (uint32_t a, uint32_t b)
+		      {
+			return times[a].first < times[b].first;
+		      });
+
+    // Interval coloring: visiting the nodes by entry time, a node reuses the
+    // lowest slot whose last node has already left, or opens a new one.
+    typedef std::pair<double, uint32_t> Busy; // exit time of the slot's node, slot
+    std::priority_queue<Busy, std::vector<Busy>, std::greater<Busy> > busy;
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t> > idle;
+    m_slot_nodes.clear ();
+    for (uint32_t i = 0; i < order.size (); i++)
+      {
+	uint32_t nodeId = order[i];
+	while (!busy.empty () && busy.top ().first < m_node_times[nodeId].first)
+	  {
+	    idle.push (busy.top ().second);
+	    busy.pop ();
+	  }
+
+	uint32_t slot;
+	if (idle.empty ())
+	  {
+	    slot = m_slot_nodes.size ();
+	    m_slot_nodes.push_back (std::vector<uint32_t> ());
+	  }
+	else
+	  {
+	    slot = idle.top ();
+	    idle.pop ();
+	  }
+	m_slot_nodes[slot].push_back (nodeId);
+	busy.push (std::make_pair (m_node_times[nodeId].second, slot));
+      }
+    return m_slot_nodes.size ();
+  }
+  const std::vector<uint32_t> &
+  Ns2NodeUtility::GetNodesInSlot (uint32_t slot)
+  {
+    return m_slot_nodes.at (slot);
+  }
 
   void
   Ns2NodeUtility::PrintInformation()
@@ -73,6 +254,8 @@ namespace ns3
     uint32_t s = m_node_times.size();
     for (uint32_t i=0 ; i<s; i++)
       {
+	if (m_node_times[i].first < 0)
+	  continue;
 	std::cout << "Node " << i << " started " << std::get<0>(m_node_times[i]) << " and ended " << std::get<1>(m_node_times[i]) << std::endl;
       }
   }
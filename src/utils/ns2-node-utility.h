@@ -5,14 +5,27 @@
 #include <sstream>
 #include <string>
 #include <fstream>
-#include <map>
+#include <vector>
+#include <stdint.h>
+
+#include "ns3/ptr.h"
 
 namespace ns3
 {
+  class Ns2BinaryTrace;
+
   class Ns2NodeUtility
   {
   public:
-    Ns2NodeUtility (std::string file_name);
+    /**
+     * \param file_name of the ns-2 mobility trace, textual or compiled, or of a SUMO FCD export
+     * \param parseThreads number of threads scanning a textual trace; the file is split on line boundaries and each thread builds its own lifetime table
+     */
+    Ns2NodeUtility (std::string file_name, uint32_t parseThreads = 1);
+    /** Takes the node lifetimes from an already loaded trace (see Ns2BinaryTrace::Load), so that the file is not read again.
+     * \param trace the loaded mobility trace
+     */
+    Ns2NodeUtility (Ptr<Ns2BinaryTrace> trace);
     /** Prints information. For debugging
     */
     void PrintInformation ();
@@ -34,11 +47,41 @@ namespace ns3
      * \return The total simulation time of the ns-2 simulation in seconds as double
      */
     double GetSimulationTime ();
+    /** Packs the nodes of the trace onto as few slots as possible. Nodes whose [entry, exit] intervals do not overlap may share a slot, so that one simulated node can play several vehicles one after the other.
+     * \return the number of slots, which is the peak number of nodes present at once
+     */
+    uint32_t AssignSlots ();
+    /**
+     * \param slot assigned by AssignSlots
+     * \return the ids of the nodes sharing the slot, by increasing entry time
+     */
+    const std::vector<uint32_t> &GetNodesInSlot (uint32_t slot);
 
   private:
+    /** Copies the lifetimes from the index of a compiled trace.
+     * \param trace the compiled trace
+     */
+    void AddTrace (const Ns2BinaryTrace &trace);
+    /** Scans the pieces of a textual trace on separate threads and merges their lifetime tables.
+     * \param begin of the trace
+     * \param end of the trace
+     * \param parseThreads number of pieces to scan concurrently
+     */
+    void ParseParallel (const char *begin, const char *end, uint32_t parseThreads);
+    /** Merges a lifetime table read from a later part of the trace.
+     * \param table of first and last time stamps indexed by node id, negative for absent ids
+     */
+    void AddLifetimes (const std::vector<std::pair<double, double> > &table);
+    /** Widens the lifetime of a node so that it covers the given time stamp.
+     * \param nodeId of the node
+     * \param time of a command issued to the node
+     */
+    void AddTime (uint32_t nodeId, double time);
+
     std::string m_file_name; /**< File name of the ns-2 mobility trace */
-    std::ifstream m_input_file; /**< input file stream object */
-    std::map <uint32_t, std::pair<double, double>> m_node_times; /**< a map to keep track of nodes entry & exit times. */
+    std::vector <std::pair<double, double>> m_node_times; /**< nodes entry & exit times indexed by node id, negative for ids not in the trace. */
+    uint32_t m_n_nodes; /**< number of node ids present in the trace */
+    std::vector <std::vector<uint32_t>> m_slot_nodes; /**< node ids assigned to every slot by AssignSlots, by entry time */
 
   };
 }
@@ -0,0 +1,247 @@
+#include "ns2-trace-mobility-model.h"
+
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+  NS_OBJECT_ENSURE_REGISTERED (Ns2TraceMobilityModel);
+
+  TypeId
+  Ns2TraceMobilityModel::GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::Ns2TraceMobilityModel")
+      .SetParent<MobilityModel> ()
+      .SetGroupName ("Mobility")
+      .AddConstructor<Ns2TraceMobilityModel> ()
+      .AddAttribute ("ChunkSize",
+                     "Number of waypoints read from the trace at once",
+                     UintegerValue (32),
+                     MakeUintegerAccessor (&Ns2TraceMobilityModel::m_chunkSize),
+                     MakeUintegerChecker<uint32_t> (1))
+    ;
+    return tid;
+  }
+
+  Ns2TraceMobilityModel::Ns2TraceMobilityModel ()
+    : m_nextTrack (0),
+      m_next (0),
+      m_end (0),
+      m_chunkSize (32),
+      m_chunkPos (0),
+      m_adrift (false),
+      m_moving (false)
+  {
+  }
+
+  Ns2TraceMobilityModel::~Ns2TraceMobilityModel ()
+  {
+  }
+
+  void
+  Ns2TraceMobilityModel::DoDispose (void)
+  {
+    m_event.Cancel ();
+    m_trace = 0;
+    std::vector<Waypoint> ().swap (m_chunk);
+    MobilityModel::DoDispose ();
+  }
+
+  void
+  Ns2TraceMobilityModel::SetTrace (Ptr<Ns2BinaryTrace> trace, uint32_t nodeId)
+  {
+    SetTracks (trace, std::vector<uint32_t> (1, nodeId));
+  }
+
+  void
+  Ns2TraceMobilityModel::SetTracks (Ptr<Ns2BinaryTrace> trace, const std::vector<uint32_t> &nodeIds)
+  {
+    m_trace = trace;
+    m_tracks = nodeIds;
+    m_nextTrack = 0;
+    m_event.Cancel ();
+    if (!m_tracks.empty ())
+      {
+	StartTrack ();
+      }
+    ScheduleNext ();
+  }
+
+  void
+  Ns2TraceMobilityModel::StartTrack (void)
+  {
+    uint32_t nodeId = m_tracks[m_nextTrack++];
+    const Ns2BinaryTraceNode &node = m_trace->GetNode (nodeId);
+    m_next = node.firstWaypoint;
+    m_end = node.firstWaypoint + node.nWaypoints;
+    m_chunk.clear ();
+    m_chunkPos = 0;
+
+    m_position = m_trace->GetInitialPosition (nodeId);
+    m_velocity = Vector ();
+    m_drift = Vector ();
+    m_adrift = false;
+    m_base = Simulator::Now ();
+    m_moving = false;
+    NotifyCourseChange ();
+  }
+
+  bool
+  Ns2TraceMobilityModel::PeekWaypoint (void)
+  {
+    if (m_chunkPos < m_chunk.size ())
+      {
+	return true;
+      }
+    if (m_next == m_end)
+      {
+	// The node has left the trace: give the chunk memory back.
+	std::vector<Waypoint> ().swap (m_chunk);
+	m_chunkPos = 0;
+	return false;
+      }
+
+    uint64_t n = std::min<uint64_t> (m_chunkSize, m_end - m_next);
+    const double *times = m_trace->GetTimes () + m_next;
+    const double *xs = m_trace->GetX () + m_next;
+    const double *ys = m_trace->GetY () + m_next;
+    const double *speeds = m_trace->GetSpeeds () + m_next;
+    m_chunk.resize (n);
+    for (uint64_t i = 0; i < n; i++)
+      {
+	Waypoint w = { times[i], xs[i], ys[i], speeds[i] };
+	m_chunk[i] = w;
+      }
+    m_trace->Release (m_next, n);
+    m_chunkPos = 0;
+    m_next += n;
+    return true;
+  }
+
+  void
+  Ns2TraceMobilityModel::ScheduleNext (void)
+  {
+    Time next = Time::Max ();
+    if (m_moving)
+      {
+	next = m_arrival;
+      }
+    if (PeekWaypoint ())
+      {
+	next = std::min (next, Seconds (m_chunk[m_chunkPos].time));
+      }
+    if (m_nextTrack < m_tracks.size ())
+      {
+	next = std::min (next, Seconds (m_trace->GetNode (m_tracks[m_nextTrack]).entryTime));
+      }
+    if (next != Time::Max ())
+      {
+	m_event = Simulator::Schedule (std::max (next - Simulator::Now (), Time (0)), &Ns2TraceMobilityModel::Advance, this);
+      }
+  }
+
+  void
+  Ns2TraceMobilityModel::Advance (void)
+  {
+    Time now = Simulator::Now ();
+    m_position = DoGetPosition ();
+    m_base = now;
+
+    if (m_moving && m_arrival <= now)
+      {
+	m_velocity = Vector ();
+	m_moving = false;
+      }
+
+    // The previous vehicle has left by now; this one enters where the trace
+    // places it, whatever movement was still under way.
+    if (m_nextTrack < m_tracks.size ()
+	&& Seconds (m_trace->GetNode (m_tracks[m_nextTrack]).entryTime) <= now)
+      {
+	StartTrack ();
+      }
+
+    while (PeekWaypoint () && Seconds (m_chunk[m_chunkPos].time) <= now)
+      {
+	const Waypoint &w = m_chunk[m_chunkPos++];
+
+	// Like Ns2MobilityHelper, a negative speed is ignored but still drops
+	// the stop of the movement under way: the node moves on, while the
+	// trace goes on planning from where it was at that time. The gap is
+	// carried into every later setdest.
+	if (w.speed < 0)
+	  {
+	    if (m_moving && !m_adrift)
+	      {
+		m_arrival = Time::Max ();
+		m_driftStart = m_position;
+		m_adrift = true;
+	      }
+	    continue;
+	  }
+	if (m_adrift)
+	  {
+	    m_drift.x += m_position.x - m_driftStart.x;
+	    m_drift.y += m_position.y - m_driftStart.y;
+	    m_adrift = false;
+	  }
+
+	// A new setdest starts from wherever the node is now, even if the
+	// previous destination was not reached yet.
+	m_velocity = Vector ();
+	m_moving = false;
+	if (w.speed == 0)
+	  {
+	    continue;
+	  }
+	double dx = w.x - (m_position.x - m_drift.x);
+	double dy = w.y - (m_position.y - m_drift.y);
+	double time = std::sqrt (dx * dx + dy * dy) / w.speed;
+	if (time == 0)
+	  {
+	    continue;
+	  }
+	m_velocity = Vector (dx / time, dy / time, 0);
+	m_arrival = Seconds (w.time + time);
+	m_moving = true;
+      }
+
+    NotifyCourseChange ();
+    ScheduleNext ();
+  }
+
+  Vector
+  Ns2TraceMobilityModel::DoGetPosition (void) const
+  {
+    Time now = Simulator::Now ();
+    if (m_moving && m_arrival < now)
+      {
+	now = m_arrival;
+      }
+    double t = (now - m_base).GetSeconds ();
+    return Vector (m_position.x + m_velocity.x * t,
+		   m_position.y + m_velocity.y * t,
+		   m_position.z + m_velocity.z * t);
+  }
+
+  void
+  Ns2TraceMobilityModel::DoSetPosition (const Vector &position)
+  {
+    m_position = position;
+    m_base = Simulator::Now ();
+    NotifyCourseChange ();
+  }
+
+  Vector
+  Ns2TraceMobilityModel::DoGetVelocity (void) const
+  {
+    if (m_moving && m_arrival <= Simulator::Now ())
+      {
+	return Vector ();
+      }
+    return m_velocity;
+  }
+}
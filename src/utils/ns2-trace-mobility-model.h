@@ -0,0 +1,103 @@
+#ifndef SUMOTRACEEXAMPLE_NS2_TRACE_MOBILITY_MODEL_H_
+#define SUMOTRACEEXAMPLE_NS2_TRACE_MOBILITY_MODEL_H_
+
+#include "ns2-binary-trace.h"
+
+#include "ns3/event-id.h"
+#include "ns3/mobility-model.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+namespace ns3
+{
+  /**
+   * Mobility model that follows one node of an ns-2 trace with the same
+   * setdest semantics as Ns2MobilityHelper, but reads the waypoints lazily.
+   *
+   * Instead of scheduling two events per waypoint when installed, the model
+   * keeps a single pending event and copies the next ChunkSize waypoints of
+   * its node from the trace only when the previous chunk is used up. The
+   * pages of a compiled (memory-mapped) trace are dropped again as soon as a
+   * chunk is copied, and the chunk itself once the node has left the trace,
+   * so memory follows the number of vehicles that are active at once instead
+   * of the length of the trace. A textual trace parsed in memory stays whole;
+   * the bound needs a compiled trace or its cache.
+   */
+  class Ns2TraceMobilityModel : public MobilityModel
+  {
+  public:
+    static TypeId GetTypeId (void);
+    Ns2TraceMobilityModel ();
+    virtual ~Ns2TraceMobilityModel ();
+
+    /**
+     * Binds the model to a node of the trace and moves it to its initial
+     * position. Must be called before the simulation starts.
+     * \param trace the loaded trace
+     * \param nodeId of the node in the trace
+     */
+    void SetTrace (Ptr<Ns2BinaryTrace> trace, uint32_t nodeId);
+    /**
+     * Binds the model to several nodes of the trace whose lifetimes do not
+     * overlap, e.g. the nodes of one slot of Ns2NodeUtility::AssignSlots.
+     * The model follows the first node right away and jumps to the initial
+     * position of each following node at its entry time.
+     * \param trace the loaded trace
+     * \param nodeIds of the nodes in the trace, by increasing entry time
+     */
+    void SetTracks (Ptr<Ns2BinaryTrace> trace, const std::vector<uint32_t> &nodeIds);
+
+  protected:
+    virtual void DoDispose (void);
+
+  private:
+    struct Waypoint
+    {
+      double time;
+      double x;
+      double y;
+      double speed;
+    };
+
+    virtual Vector DoGetPosition (void) const;
+    virtual void DoSetPosition (const Vector &position);
+    virtual Vector DoGetVelocity (void) const;
+
+    /**
+     * Applies the waypoints and arrivals that are due, then schedules the
+     * next one.
+     */
+    void Advance (void);
+    /**
+     * \return true if a waypoint is available, loading the next chunk if needed
+     */
+    bool PeekWaypoint (void);
+    void ScheduleNext (void);
+    /**
+     * Moves to the initial position of the next track and starts reading its waypoints.
+     */
+    void StartTrack (void);
+
+    Ptr<Ns2BinaryTrace> m_trace;  /**< the trace being followed */
+    std::vector<uint32_t> m_tracks; /**< trace nodes followed one after the other */
+    uint32_t m_nextTrack;         /**< index in m_tracks of the next track to start */
+    uint64_t m_next;              /**< index in the trace of the next waypoint to load */
+    uint64_t m_end;               /**< index in the trace past the last waypoint of the node */
+    uint32_t m_chunkSize;         /**< number of waypoints loaded at once */
+    std::vector<Waypoint> m_chunk; /**< loaded waypoints that are not applied yet */
+    uint32_t m_chunkPos;          /**< next waypoint to apply in m_chunk */
+
+    Vector m_position;            /**< position at m_base */
+    Vector m_velocity;            /**< current velocity */
+    Vector m_drift;               /**< how far the node is off the course the trace plans, see Advance */
+    Vector m_driftStart;          /**< position at which the node started drifting */
+    bool m_adrift;                /**< whether a negative speed setdest left the node moving on */
+    Time m_base;                  /**< time of the last course change */
+    Time m_arrival;               /**< time the current movement reaches its destination */
+    bool m_moving;                /**< whether a movement is under way */
+    EventId m_event;              /**< the next waypoint or arrival */
+  };
+}
+
+#endif
@@ -0,0 +1,184 @@
+#include "ns2-trace-scanner.h"
+#include "trace-text.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3
+{
+  namespace
+  {
+    using TraceText::ParseUnsigned;
+    using TraceText::ParseDouble;
+
+    inline const char *
+    SkipSpaces (const char *p, const char *end)
+    {
+      while (p < end && (*p == ' ' || *p == '\t'))
+	{
+	  ++p;
+	}
+      return p;
+    }
+
+    inline bool
+    Expect (const char *&p, const char *end, const char *literal, std::size_t len)
+    {
+      if (static_cast<std::size_t> (end - p) < len || std::memcmp (p, literal, len) != 0)
+	{
+	  return false;
+	}
+      p += len;
+      return true;
+    }
+
+    inline bool
+    ParseNodeRef (const char *&p, const char *end, uint32_t &nodeId)
+    {
+      return Expect (p, end, "$node_(", 7) && ParseUnsigned (p, end, nodeId) && Expect (p, end, ")", 1);
+    }
+  }
+
+  Ns2TraceScanner::Ns2TraceScanner (const char *begin, const char *end)
+    : m_cur (begin),
+      m_end (end)
+  {
+  }
+
+  std::vector<const char *>
+  Ns2TraceScanner::SplitLines (const char *begin, const char *end, uint32_t parts)
+  {
+    std::vector<const char *> bounds (1, begin);
+    std::size_t size = end - begin;
+    for (uint32_t i = 1; i < parts; i++)
+      {
+	const char *p = std::max (begin + size / parts * i, bounds.back ());
+	const char *eol = static_cast<const char *> (std::memchr (p, '\n', end - p));
+	if (eol == 0 || eol + 1 == end)
+	  {
+	    break;
+	  }
+	if (eol + 1 > bounds.back ())
+	  {
+	    bounds.push_back (eol + 1);
+	  }
+      }
+    bounds.push_back (end);
+    return bounds;
+  }
+
+  bool
+  Ns2TraceScanner::Next (Ns2TraceRecord &record)
+  {
+    while (m_cur < m_end)
+      {
+	const char *line = m_cur;
+	const char *eol = static_cast<const char *> (std::memchr (line, '\n', m_end - line));
+	if (eol == 0)
+	  {
+	    eol = m_end;
+	    m_cur = m_end;
+	  }
+	else
+	  {
+	    m_cur = eol + 1;
+	  }
+
+	if (ParseLine (line, eol, record))
+	  {
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  bool
+  Ns2TraceScanner::ParseLine (const char *p, const char *eol, Ns2TraceRecord &record) const
+  {
+    p = SkipSpaces (p, eol);
+    if (p == eol)
+      {
+	return false;
+      }
+
+    if (*p == '$' && p + 1 < eol && p[1] == 'n' && p + 2 < eol && p[2] == 'o')
+      {
+	// $node_(i) set X_ value
+	if (!ParseNodeRef (p, eol, record.nodeId))
+	  {
+	    return false;
+	  }
+	p = SkipSpaces (p, eol);
+	if (!Expect (p, eol, "set", 3))
+	  {
+	    return false;
+	  }
+	p = SkipSpaces (p, eol);
+	if (eol - p < 2 || p[1] != '_')
+	  {
+	    return false;
+	  }
+	switch (*p)
+	  {
+	  case 'X':
+	    record.kind = Ns2TraceRecord::SET_X;
+	    break;
+	  case 'Y':
+	    record.kind = Ns2TraceRecord::SET_Y;
+	    break;
+	  case 'Z':
+	    record.kind = Ns2TraceRecord::SET_Z;
+	    break;
+	  default:
+	    return false;
+	  }
+	p = SkipSpaces (p + 2, eol);
+	record.time = 0;
+	return ParseDouble (p, eol, record.x);
+      }
+
+    // $ns_ at time "$node_(i) command ..."
+    if (!Expect (p, eol, "$ns_", 4))
+      {
+	return false;
+      }
+    p = SkipSpaces (p, eol);
+    if (!Expect (p, eol, "at", 2))
+      {
+	return false;
+      }
+    p = SkipSpaces (p, eol);
+    if (!ParseDouble (p, eol, record.time))
+      {
+	return false;
+      }
+    p = SkipSpaces (p, eol);
+    if (!Expect (p, eol, "\"", 1) || !ParseNodeRef (p, eol, record.nodeId))
+      {
+	return false;
+      }
+
+    record.kind = Ns2TraceRecord::AT;
+    p = SkipSpaces (p, eol);
+    if (Expect (p, eol, "setdest", 7))
+      {
+	p = SkipSpaces (p, eol);
+	if (!ParseDouble (p, eol, record.x))
+	  {
+	    return true;
+	  }
+	p = SkipSpaces (p, eol);
+	if (!ParseDouble (p, eol, record.y))
+	  {
+	    return true;
+	  }
+	p = SkipSpaces (p, eol);
+	if (!ParseDouble (p, eol, record.speed))
+	  {
+	    return true;
+	  }
+	record.kind = Ns2TraceRecord::SETDEST;
+      }
+    return true;
+  }
+}
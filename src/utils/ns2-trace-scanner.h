@@ -0,0 +1,65 @@
+#ifndef SUMOTRACEEXAMPLE_NS2_TRACE_SCANNER_H_
+#define SUMOTRACEEXAMPLE_NS2_TRACE_SCANNER_H_
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+  /**
+   * One statement of an ns-2 mobility script, as produced by Ns2TraceScanner.
+   */
+  struct Ns2TraceRecord
+  {
+    enum Kind
+    {
+      SET_X,   /**< $node_(i) set X_ value */
+      SET_Y,   /**< $node_(i) set Y_ value */
+      SET_Z,   /**< $node_(i) set Z_ value */
+      SETDEST, /**< $ns_ at time "$node_(i) setdest x y speed" */
+      AT       /**< any other $ns_ at time "$node_(i) ..." command */
+    };
+
+    Kind kind;
+    uint32_t nodeId;
+    double time;  /**< scheduled time of SETDEST and AT records */
+    double x;     /**< destination x of SETDEST, or the value of SET_X/SET_Y/SET_Z */
+    double y;     /**< destination y of SETDEST */
+    double speed; /**< speed of SETDEST */
+  };
+
+  /**
+   * Hand-written single-pass tokenizer for ns-2 mobility scripts, such as the
+   * ones written by SUMO's traceExporter.py. It works directly on a character
+   * range (usually a MappedFile) and never allocates. Lines that are not
+   * recognized are skipped.
+   */
+  class Ns2TraceScanner
+  {
+  public:
+    Ns2TraceScanner (const char *begin, const char *end);
+    /**
+     * Scans forward to the next recognized statement.
+     * \param record filled in with the statement
+     * \return false once the end of the range is reached
+     */
+    bool Next (Ns2TraceRecord &record);
+    /**
+     * Splits a range into pieces of about the same size that start at the
+     * beginning of a line, so that each piece can be scanned independently.
+     * \param begin of the range
+     * \param end of the range
+     * \param parts wanted number of pieces; fewer are returned for short ranges
+     * \return the boundaries of the pieces, from begin to end
+     */
+    static std::vector<const char *> SplitLines (const char *begin, const char *end, uint32_t parts);
+
+  private:
+    bool ParseLine (const char *p, const char *eol, Ns2TraceRecord &record) const;
+
+    const char *m_cur; /**< start of the next line to scan */
+    const char *m_end; /**< end of the range */
+  };
+}
+
+#endif
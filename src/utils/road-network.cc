@@ -0,0 +1,347 @@
+#include "road-network.h"
+#include "mapped-file.h"
+#include "trace-text.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <set>
+
+namespace ns3
+{
+  namespace
+  {
+    using TraceText::IsName;
+    using TraceText::IsTag;
+    using TraceText::NextAttribute;
+    using TraceText::ParseDouble;
+    using TraceText::ParseUnsigned;
+    using TraceText::SkipPast;
+    using TraceText::TagEnd;
+
+    /**
+     * Connection as written in the file, resolved once every edge is known.
+     */
+    struct RawConnection
+    {
+      std::string from;
+      std::string to;
+      uint32_t fromLane;
+      std::string via;
+    };
+
+    /**
+     * Parses a shape attribute ("x,y[,z] x,y[,z] ...") into lane.
+     */
+    void
+    ReadShape (const char *p, const char *end, RoadLane &lane)
+    {
+      lane.shape.clear ();
+      lane.length = 0;
+      while (p < end)
+	{
+	  Vector point;
+	  if (!ParseDouble (p, end, point.x) || p == end || *p != ',')
+	    {
+	      break;
+	    }
+	  ++p;
+	  if (!ParseDouble (p, end, point.y))
+	    {
+	      break;
+	    }
+	  if (p < end && *p == ',')
+	    {
+	      ++p;
+	      double z;
+	      ParseDouble (p, end, z);
+	    }
+	  point.z = 0;
+	  if (!lane.shape.empty ())
+	    {
+	      lane.length += CalculateDistance (lane.shape.back (), point);
+	    }
+	  lane.shape.push_back (point);
+	  while (p < end && *p == ' ')
+	    {
+	      ++p;
+	    }
+	}
+    }
+
+    inline double
+    TravelTime (const RoadLane &lane)
+    {
+      return lane.speed > 0 ? lane.length / lane.speed : 0;
+    }
+  }
+
+  RoadNetwork::RoadNetwork (std::string file_name)
+  {
+    MappedFile file (file_name);
+    if (!file.IsOpen () || file.GetSize () == 0)
+      {
+	return;
+      }
+    const char *cur = file.GetData ();
+    const char *end = cur + file.GetSize ();
+
+    std::map<std::string, uint32_t> edgeIds;
+    std::map<std::string, RoadLane> internalLanes;
+    std::vector<RawConnection> connections;
+    bool inEdge = false;
+    bool internal = false;
+
+    while (cur < end)
+      {
+	const char *p = static_cast<const char *> (std::memchr (cur, '<', end - cur));
+	if (p == 0)
+	  {
+	    break;
+	  }
+	++p;
+	if (p < end && *p == '!')
+	  {
+	    cur = (end - p >= 3 && std::memcmp (p, "!--", 3) == 0)
+	      ? SkipPast (p + 3, end, "-->", 3) : TagEnd (p, end);
+	    continue;
+	  }
+	if (p < end && *p == '?')
+	  {
+	    cur = SkipPast (p, end, "?>", 2);
+	    continue;
+	  }
+	const char *tagEnd = TagEnd (p, end);
+	cur = tagEnd < end ? tagEnd + 1 : end;
+	bool selfClosing = tagEnd > p && tagEnd[-1] == '/';
+
+	const char *name;
+	std::size_t nameLen;
+	const char *value;
+	const char *valueEnd;
+	if (IsTag (p, end, "edge", 4))
+	  {
+	    RoadEdge edge;
+	    internal = false;
+	    const char *q = p + 4;
+	    while (NextAttribute (q, tagEnd, name, nameLen, value, valueEnd))
+	      {
+		if (IsName (name, nameLen, "id", 2))
+		  {
+		    edge.id.assign (value, valueEnd);
+		  }
+		else if (IsName (name, nameLen, "function", 8))
+		  {
+		    internal = !(valueEnd - value == 6 && std::memcmp (value, "normal", 6) == 0);
+		  }
+	      }
+	    inEdge = !selfClosing;
+	    if (!internal)
+	      {
+		edge.lane.speed = 0;
+		edge.lane.length = 0;
+		edgeIds[edge.id] = m_edges.size ();
+		m_edges.push_back (edge);
+	      }
+	  }
+	else if (IsTag (p, end, "/edge", 5))
+	  {
+	    inEdge = false;
+	  }
+	else if (inEdge && IsTag (p, end, "lane", 4))
+	  {
+	    std::string id;
+	    uint32_t index = 0;
+	    RoadLane lane;
+	    lane.speed = 0;
+	    lane.length = 0;
+	    const char *q = p + 4;
+	    while (NextAttribute (q, tagEnd, name, nameLen, value, valueEnd))
+	      {
+		if (IsName (name, nameLen, "id", 2))
+		  {
+		    id.assign (value, valueEnd);
+		  }
+		else if (IsName (name, nameLen, "index", 5))
+		  {
+		    ParseUnsigned (value, valueEnd, index);
+		  }
+		else if (IsName (name, nameLen, "speed", 5))
+		  {
+		    ParseDouble (value, valueEnd, lane.speed);
+		  }
+		else if (IsName (name, nameLen, "shape", 5))
+		  {
+		    ReadShape (value, valueEnd, lane);
+		  }
+	      }
+	    if (internal)
+	      {
+		internalLanes[id] = lane;
+	      }
+	    else if (index == 0)
+	      {
+		m_edges.back ().lane = lane;
+	      }
+	  }
+	else if (IsTag (p, end, "connection", 10))
+	  {
+	    RawConnection connection;
+	    connection.fromLane = 0;
+	    const char *q = p + 10;
+	    while (NextAttribute (q, tagEnd, name, nameLen, value, valueEnd))
+	      {
+		if (IsName (name, nameLen, "from", 4))
+		  {
+		    connection.from.assign (value, valueEnd);
+		  }
+		else if (IsName (name, nameLen, "to", 2))
+		  {
+		    connection.to.assign (value, valueEnd);
+		  }
+		else if (IsName (name, nameLen, "fromLane", 8))
+		  {
+		    ParseUnsigned (value, valueEnd, connection.fromLane);
+		  }
+		else if (IsName (name, nameLen, "via", 3))
+		  {
+		    connection.via.assign (value, valueEnd);
+		  }
+	      }
+	    connections.push_back (connection);
+	  }
+      }
+
+    // Junctions with internal junction points split the crossing into
+    // several internal lanes, linked by connections from internal edges.
+    std::map<std::string, std::string> nextInternal;
+    for (std::size_t i = 0; i < connections.size (); i++)
+      {
+	const RawConnection &c = connections[i];
+	if (!c.via.empty () && edgeIds.find (c.from) == edgeIds.end ())
+	  {
+	    nextInternal[c.from + "_" + std::to_string (c.fromLane)] = c.via;
+	  }
+      }
+
+    // One connection per pair of edges, preferring the ones leaving from the
+    // first lane, which is the one vehicles drive on.
+    std::set<std::pair<uint32_t, uint32_t> > seen;
+    for (int pass = 0; pass < 2; pass++)
+      {
+	for (std::size_t i = 0; i < connections.size (); i++)
+	  {
+	    const RawConnection &c = connections[i];
+	    if ((c.fromLane == 0) != (pass == 0))
+	      {
+		continue;
+	      }
+	    std::map<std::string, uint32_t>::const_iterator from = edgeIds.find (c.from);
+	    std::map<std::string, uint32_t>::const_iterator to = edgeIds.find (c.to);
+	    if (from == edgeIds.end () || to == edgeIds.end ()
+		|| !seen.insert (std::make_pair (from->second, to->second)).second)
+	      {
+		continue;
+	      }
+
+	    RoadConnection connection;
+	    connection.to = to->second;
+	    connection.travelTime = 0;
+	    std::string via = c.via;
+	    while (!via.empty () && connection.via.size () < internalLanes.size ())
+	      {
+		std::map<std::string, RoadLane>::const_iterator lane = internalLanes.find (via);
+		if (lane == internalLanes.end ())
+		  {
+		    break;
+		  }
+		connection.via.push_back (lane->second);
+		connection.travelTime += TravelTime (lane->second);
+		std::map<std::string, std::string>::const_iterator next = nextInternal.find (via);
+		via = next == nextInternal.end () ? std::string () : next->second;
+	      }
+	    m_edges[from->second].connections.push_back (connection);
+	  }
+      }
+
+    m_trees.resize (m_edges.size ());
+  }
+
+  bool
+  RoadNetwork::IsValid () const
+  {
+    return !m_edges.empty ();
+  }
+
+  uint32_t
+  RoadNetwork::GetNEdges () const
+  {
+    return m_edges.size ();
+  }
+
+  const RoadEdge &
+  RoadNetwork::GetEdge (uint32_t edge) const
+  {
+    return m_edges[edge];
+  }
+
+  bool
+  RoadNetwork::FindRoute (uint32_t from, uint32_t to, std::vector<uint32_t> &route)
+  {
+    route.clear ();
+    if (m_trees[from].empty ())
+      {
+	BuildTree (from);
+      }
+    const std::vector<std::pair<int32_t, int32_t> > &tree = m_trees[from];
+    if (to != from && tree[to].first < 0)
+      {
+	return false;
+      }
+    for (uint32_t edge = to; edge != from; edge = tree[edge].first)
+      {
+	route.push_back (tree[edge].second);
+      }
+    std::reverse (route.begin (), route.end ());
+    return true;
+  }
+
+  void
+  RoadNetwork::BuildTree (uint32_t from)
+  {
+    typedef std::pair<double, uint32_t> Entry;
+    std::vector<std::pair<int32_t, int32_t> > &tree = m_trees[from];
+    tree.assign (m_edges.size (), std::make_pair (-1, -1));
+    std::vector<double> arrival (m_edges.size (), std::numeric_limits<double>::infinity ());
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > queue;
+
+    // Times are taken at the end of each edge.
+    arrival[from] = TravelTime (m_edges[from].lane);
+    queue.push (Entry (arrival[from], from));
+    while (!queue.empty ())
+      {
+	Entry top = queue.top ();
+	queue.pop ();
+	if (top.first > arrival[top.second])
+	  {
+	    continue;
+	  }
+	const RoadEdge &edge = m_edges[top.second];
+	for (uint32_t i = 0; i < edge.connections.size (); i++)
+	  {
+	    const RoadConnection &c = edge.connections[i];
+	    double time = top.first + c.travelTime + TravelTime (m_edges[c.to].lane);
+	    if (time < arrival[c.to])
+	      {
+		arrival[c.to] = time;
+		tree[c.to] = std::make_pair (static_cast<int32_t> (top.second), static_cast<int32_t> (i));
+		queue.push (Entry (time, c.to));
+	      }
+	  }
+      }
+  }
+}
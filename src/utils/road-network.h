@@ -0,0 +1,102 @@
+#ifndef SUMOTRACEEXAMPLE_ROAD_NETWORK_H_
+#define SUMOTRACEEXAMPLE_ROAD_NETWORK_H_
+
+#include "ns3/vector.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+  /**
+   * Centre line of a lane, driven at a constant speed.
+   */
+  struct RoadLane
+  {
+    std::vector<Vector> shape; /**< points of the lane, in driving direction */
+    double speed;              /**< speed limit in m/s */
+    double length;             /**< length of the shape in meters */
+  };
+
+  /**
+   * Turn from one edge into another through a junction.
+   */
+  struct RoadConnection
+  {
+    uint32_t to;               /**< index of the edge the turn leads to */
+    std::vector<RoadLane> via; /**< internal lanes crossing the junction, in order */
+    double travelTime;         /**< time to cross the junction at the speed limits */
+  };
+
+  /**
+   * Normal (non-internal) edge of the network. Only its rightmost lane is
+   * kept, vehicles drive along it at its speed limit.
+   */
+  struct RoadEdge
+  {
+    std::string id;
+    RoadLane lane;                           /**< lane with index 0 */
+    std::vector<RoadConnection> connections; /**< turns leaving the end of the edge */
+  };
+
+  /**
+   * Road graph read from a SUMO network (*.net.xml), as written by netedit or
+   * netconvert: the normal edges with the shape and speed limit of their first
+   * lane, and the connections between them with the shapes of the internal
+   * lanes that cross each junction.
+   *
+   * Routes are the fastest paths at the speed limits, so free flowing
+   * vehicles on them follow the same edges duarouter would pick on an empty
+   * network. Shortest path trees are computed once per source edge and kept,
+   * which makes routing many vehicles over a small network cheap.
+   */
+  class RoadNetwork
+  {
+  public:
+    /**
+     * Reads a network. Use IsValid() to check the result.
+     * \param file_name of the SUMO network
+     */
+    RoadNetwork (std::string file_name);
+    /**
+     * \return true if the file could be read and has at least one edge
+     */
+    bool IsValid () const;
+    /**
+     * \return the number of normal edges
+     */
+    uint32_t GetNEdges () const;
+    /**
+     * \param edge index of the edge
+     * \return the edge
+     */
+    const RoadEdge &GetEdge (uint32_t edge) const;
+    /**
+     * Finds the fastest route between two edges.
+     * \param from index of the first edge
+     * \param to index of the last edge
+     * \param route filled in with the index of every connection taken, in
+     * order; each one is an index into the connections of the previous edge
+     * \return false if to can not be reached from from
+     */
+    bool FindRoute (uint32_t from, uint32_t to, std::vector<uint32_t> &route);
+
+  private:
+    /**
+     * Runs Dijkstra over the connections from one edge.
+     * \param from index of the source edge
+     */
+    void BuildTree (uint32_t from);
+
+    std::vector<RoadEdge> m_edges; /**< normal edges */
+    /**
+     * For every source edge whose tree was built, the connection taken to
+     * reach each edge as (previous edge, connection index), or -1 entries
+     * for edges that can not be reached. Empty until the tree is built.
+     */
+    std::vector<std::vector<std::pair<int32_t, int32_t> > > m_trees;
+  };
+}
+
+#endif
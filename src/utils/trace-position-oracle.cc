@@ -0,0 +1,79 @@
+#include "trace-position-oracle.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+  TracePositionOracle::TracePositionOracle (Ptr<const Ns2BinaryTrace> trace)
+  {
+    uint32_t nNodes = trace->GetNNodes ();
+    m_entry.resize (nNodes);
+    m_exit.resize (nNodes);
+    m_first.resize (nNodes + 1);
+
+    std::vector<Ns2TrackVertex> track;
+    for (uint32_t i = 0; i < nNodes; i++)
+      {
+	const Ns2BinaryTraceNode &node = trace->GetNode (i);
+	m_entry[i] = node.entryTime;
+	m_exit[i] = node.exitTime;
+	m_first[i] = m_times.size ();
+
+	// A node with no movement at all stays where it was placed.
+	trace->GetTrack (i, track);
+	if (track.empty ())
+	  {
+	    Ns2TrackVertex initial = { node.entryTime, node.x, node.y };
+	    track.push_back (initial);
+	  }
+	for (std::size_t v = 0; v < track.size (); v++)
+	  {
+	    m_times.push_back (track[v].time);
+	    m_x.push_back (track[v].x);
+	    m_y.push_back (track[v].y);
+	  }
+      }
+    m_first[nNodes] = m_times.size ();
+  }
+
+  uint32_t
+  TracePositionOracle::GetNNodes () const
+  {
+    return m_entry.size ();
+  }
+
+  double
+  TracePositionOracle::GetEntryTime (uint32_t nodeId) const
+  {
+    return nodeId < m_entry.size () ? m_entry[nodeId] : -1;
+  }
+
+  bool
+  TracePositionOracle::GetPosition (uint32_t nodeId, double time, Vector &position) const
+  {
+    if (nodeId >= m_entry.size () || m_entry[nodeId] < 0 || time < m_entry[nodeId] || time > m_exit[nodeId])
+      {
+	return false;
+      }
+
+    // Last vertex at or before time; before the first one the node is still
+    // at its initial position, after the last one it rests there.
+    const double *begin = &m_times[0] + m_first[nodeId];
+    const double *end = &m_times[0] + m_first[nodeId + 1];
+    const double *next = std::upper_bound (begin, end, time);
+    if (next == begin)
+      {
+	position = Vector (m_x[m_first[nodeId]], m_y[m_first[nodeId]], 0);
+	return true;
+      }
+    uint64_t v = (next - 1) - &m_times[0];
+    if (next == end || *next <= m_times[v])
+      {
+	position = Vector (m_x[v], m_y[v], 0);
+	return true;
+      }
+    double f = (time - m_times[v]) / (*next - m_times[v]);
+    position = Vector (m_x[v] + (m_x[v + 1] - m_x[v]) * f, m_y[v] + (m_y[v + 1] - m_y[v]) * f, 0);
+    return true;
+  }
+}
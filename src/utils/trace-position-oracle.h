@@ -0,0 +1,59 @@
+#ifndef SUMOTRACEEXAMPLE_TRACE_POSITION_ORACLE_H_
+#define SUMOTRACEEXAMPLE_TRACE_POSITION_ORACLE_H_
+
+#include "ns2-binary-trace.h"
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/vector.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+  /**
+   * Ground truth positions of the vehicles of a mobility trace, independent
+   * of the mobility models installed in the simulation.
+   *
+   * The movement of every node is rebuilt once (Ns2BinaryTrace::GetTrack)
+   * into time ordered vertices stored back to back, so the position of a
+   * node at any instant is a binary search over its vertices followed by a
+   * linear interpolation.
+   */
+  class TracePositionOracle : public SimpleRefCount<TracePositionOracle>
+  {
+  public:
+    /**
+     * \param trace whose movement is the ground truth
+     */
+    TracePositionOracle (Ptr<const Ns2BinaryTrace> trace);
+    /**
+     * \return the number of node slots of the trace
+     */
+    uint32_t GetNNodes () const;
+    /**
+     * \param nodeId of the node in the trace
+     * \return the time the node enters the simulation, negative if it is not in the trace
+     */
+    double GetEntryTime (uint32_t nodeId) const;
+    /**
+     * Looks up where a node is, in O(log n) for a node with n vertices.
+     * \param nodeId of the node in the trace
+     * \param time in seconds
+     * \param position filled in with the position of the node
+     * \return false if the node is not in the simulation at that time
+     */
+    bool GetPosition (uint32_t nodeId, double time, Vector &position) const;
+
+  private:
+    std::vector<double> m_entry;    /**< entry time by node id */
+    std::vector<double> m_exit;     /**< exit time by node id */
+    std::vector<uint64_t> m_first;  /**< index of the first vertex by node id, plus the total at the end */
+    std::vector<double> m_times;    /**< vertex times */
+    std::vector<double> m_x;        /**< vertex x */
+    std::vector<double> m_y;        /**< vertex y */
+  };
+}
+
+#endif
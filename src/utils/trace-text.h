@@ -0,0 +1,241 @@
+#ifndef SUMOTRACEEXAMPLE_TRACE_TEXT_H_
+#define SUMOTRACEEXAMPLE_TRACE_TEXT_H_
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+namespace ns3
+{
+  /**
+   * Number and XML tag parsing shared by the hand-written trace readers
+   * (ns-2 scripts, SUMO FCD XML and SUMO networks). The functions work on a
+   * character range, advance the cursor past what they consumed and never
+   * allocate.
+   */
+  namespace TraceText
+  {
+    const double kPow10[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    inline bool
+    ParseUnsigned (const char *&p, const char *end, uint32_t &value)
+    {
+      const char *start = p;
+      uint32_t v = 0;
+      while (p < end && *p >= '0' && *p <= '9')
+	{
+	  v = v * 10 + (*p - '0');
+	  ++p;
+	}
+      value = v;
+      return p != start;
+    }
+
+    /**
+     * Parses a plain decimal number ([-]digits[.digits][e[-]digits]).
+     * Mantissas of up to 19 significant digits scaled by exact powers of ten
+     * round the same way strtod does for the values found in SUMO exports.
+     */
+    inline bool
+    ParseDouble (const char *&p, const char *end, double &value)
+    {
+      bool negative = false;
+      if (p < end && (*p == '-' || *p == '+'))
+	{
+	  negative = (*p == '-');
+	  ++p;
+	}
+
+      uint64_t mantissa = 0;
+      int digits = 0;
+      int scale = 0;
+      bool any = false;
+      while (p < end && *p >= '0' && *p <= '9')
+	{
+	  if (digits < 19)
+	    {
+	      mantissa = mantissa * 10 + (*p - '0');
+	      if (mantissa != 0)
+		{
+		  ++digits;
+		}
+	    }
+	  else
+	    {
+	      ++scale;
+	    }
+	  any = true;
+	  ++p;
+	}
+      if (p < end && *p == '.')
+	{
+	  ++p;
+	  while (p < end && *p >= '0' && *p <= '9')
+	    {
+	      if (digits < 19)
+		{
+		  mantissa = mantissa * 10 + (*p - '0');
+		  if (mantissa != 0)
+		    {
+		      ++digits;
+		    }
+		  --scale;
+		}
+	      any = true;
+	      ++p;
+	    }
+	}
+      if (!any)
+	{
+	  return false;
+	}
+      if (p < end && (*p == 'e' || *p == 'E'))
+	{
+	  const char *q = p + 1;
+	  bool expNegative = false;
+	  if (q < end && (*q == '-' || *q == '+'))
+	    {
+	      expNegative = (*q == '-');
+	      ++q;
+	    }
+	  uint32_t exponent;
+	  if (ParseUnsigned (q, end, exponent))
+	    {
+	      scale += expNegative ? -static_cast<int> (exponent) : static_cast<int> (exponent);
+	      p = q;
+	    }
+	}
+
+      double v = static_cast<double> (mantissa);
+      while (scale > 22)
+	{
+	  v *= kPow10[22];
+	  scale -= 22;
+	}
+      while (scale < -22)
+	{
+	  v /= kPow10[22];
+	  scale += 22;
+	}
+      v = (scale >= 0) ? v * kPow10[scale] : v / kPow10[-scale];
+      value = negative ? -v : v;
+      return true;
+    }
+
+    inline bool
+    IsSpace (char c)
+    {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    /**
+     * Checks that the tag starting at p has the given name.
+     */
+    inline bool
+    IsTag (const char *p, const char *end, const char *name, std::size_t len)
+    {
+      return static_cast<std::size_t> (end - p) > len && std::memcmp (p, name, len) == 0
+	&& (IsSpace (p[len]) || p[len] == '/' || p[len] == '>');
+    }
+
+    /**
+     * \return the '>' closing the tag that p is in, skipping quoted attribute values, or end
+     */
+    inline const char *
+    TagEnd (const char *p, const char *end)
+    {
+      while (p < end && *p != '>')
+	{
+	  if (*p == '"' || *p == '\'')
+	    {
+	      const char *close = static_cast<const char *> (std::memchr (p + 1, *p, end - p - 1));
+	      if (close == 0)
+		{
+		  return end;
+		}
+	      p = close;
+	    }
+	  ++p;
+	}
+      return p;
+    }
+
+    /**
+     * \return the first character after the given terminator, or end
+     */
+    inline const char *
+    SkipPast (const char *p, const char *end, const char *terminator, std::size_t len)
+    {
+      while (p < end)
+	{
+	  const char *q = static_cast<const char *> (std::memchr (p, terminator[0], end - p));
+	  if (q == 0 || static_cast<std::size_t> (end - q) < len)
+	    {
+	      return end;
+	    }
+	  if (std::memcmp (q, terminator, len) == 0)
+	    {
+	      return q + len;
+	    }
+	  p = q + 1;
+	}
+      return end;
+    }
+
+    /**
+     * Reads the next name="value" pair of a tag.
+     * \return false once there are no more attributes
+     */
+    inline bool
+    NextAttribute (const char *&p, const char *end, const char *&name, std::size_t &nameLen,
+		   const char *&value, const char *&valueEnd)
+    {
+      while (p < end && IsSpace (*p))
+	{
+	  ++p;
+	}
+      name = p;
+      while (p < end && *p != '=' && *p != '/' && !IsSpace (*p))
+	{
+	  ++p;
+	}
+      nameLen = p - name;
+      while (p < end && IsSpace (*p))
+	{
+	  ++p;
+	}
+      if (nameLen == 0 || p == end || *p != '=')
+	{
+	  return false;
+	}
+      ++p;
+      while (p < end && IsSpace (*p))
+	{
+	  ++p;
+	}
+      if (p == end || (*p != '"' && *p != '\''))
+	{
+	  return false;
+	}
+      value = p + 1;
+      valueEnd = static_cast<const char *> (std::memchr (value, *p, end - value));
+      if (valueEnd == 0)
+	{
+	  return false;
+	}
+      p = valueEnd + 1;
+      return true;
+    }
+
+    inline bool
+    IsName (const char *name, std::size_t nameLen, const char *expected, std::size_t len)
+    {
+      return nameLen == len && std::memcmp (name, expected, len) == 0;
+    }
+  }
+}
+
+#endif
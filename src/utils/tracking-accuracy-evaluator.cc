@@ -0,0 +1,164 @@
+#include "tracking-accuracy-evaluator.h"
+
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+  namespace
+  {
+    const double kMinError = 0.01;    /**< upper edge of the first bin, in meters */
+    const double kBinGrowth = 1.01;   /**< ratio between the edges of consecutive bins */
+    const uint32_t kNBins = 2000;     /**< covers errors up to about 4000 km */
+
+    inline uint32_t
+    BinOf (double error)
+    {
+      if (error < kMinError)
+	{
+	  return 0;
+	}
+      uint32_t bin = 1 + static_cast<uint32_t> (std::log (error / kMinError) / std::log (kBinGrowth));
+      return std::min (bin, kNBins - 1);
+    }
+
+    inline double
+    UpperEdge (uint32_t bin)
+    {
+      return kMinError * std::pow (kBinGrowth, bin);
+    }
+  }
+
+  TrackingAccuracyEvaluator::TrackingAccuracyEvaluator (Ptr<const TracePositionOracle> oracle,
+							EstimateCallback estimate)
+    : m_oracle (oracle),
+      m_estimate (estimate),
+      m_bins (kNBins),
+      m_samples (0),
+      m_unknown (0),
+      m_sum (0),
+      m_max (0)
+  {
+  }
+
+  void
+  TrackingAccuracyEvaluator::AddNode (uint32_t id, const std::vector<uint32_t> &vehicles)
+  {
+    TrackedNode node;
+    node.id = id;
+    node.vehicles = vehicles;
+    node.current = 0;
+    m_nodes.push_back (node);
+  }
+
+  void
+  TrackingAccuracyEvaluator::Start (Time interval, Time stop)
+  {
+    m_interval = interval;
+    m_stop = stop;
+    m_sampleEvent = Simulator::ScheduleNow (&TrackingAccuracyEvaluator::Sample, this);
+  }
+
+  void
+  TrackingAccuracyEvaluator::Sample (void)
+  {
+    double now = Simulator::Now ().GetSeconds ();
+    Vector truth;
+    Vector estimate;
+    Time received;
+    for (std::size_t i = 0; i < m_nodes.size (); i++)
+      {
+	// Vehicles sharing a node take turns, so the one on the node now is the
+	// last one that has entered.
+	TrackedNode &node = m_nodes[i];
+	while (node.current + 1 < node.vehicles.size ()
+	       && m_oracle->GetEntryTime (node.vehicles[node.current + 1]) <= now)
+	  {
+	    node.current++;
+	  }
+	if (node.vehicles.empty () || !m_oracle->GetPosition (node.vehicles[node.current], now, truth))
+	  {
+	    continue;
+	  }
+	// A report older than the vehicle came from the one before it.
+	if (!m_estimate (node.id, estimate, received)
+	    || received.GetSeconds () < m_oracle->GetEntryTime (node.vehicles[node.current]))
+	  {
+	    m_unknown++;
+	    continue;
+	  }
+	double dx = estimate.x - truth.x;
+	double dy = estimate.y - truth.y;
+	Add (std::sqrt (dx * dx + dy * dy));
+      }
+
+    if (Simulator::Now () + m_interval <= m_stop)
+      {
+	m_sampleEvent = Simulator::Schedule (m_interval, &TrackingAccuracyEvaluator::Sample, this);
+      }
+  }
+
+  void
+  TrackingAccuracyEvaluator::Add (double error)
+  {
+    m_bins[BinOf (error)]++;
+    m_samples++;
+    m_sum += error;
+    m_max = std::max (m_max, error);
+  }
+
+  uint64_t
+  TrackingAccuracyEvaluator::GetNSamples () const
+  {
+    return m_samples;
+  }
+
+  uint64_t
+  TrackingAccuracyEvaluator::GetNUnknown () const
+  {
+    return m_unknown;
+  }
+
+  double
+  TrackingAccuracyEvaluator::GetMean () const
+  {
+    return m_samples > 0 ? m_sum / m_samples : 0;
+  }
+
+  double
+  TrackingAccuracyEvaluator::GetMax () const
+  {
+    return m_max;
+  }
+
+  double
+  TrackingAccuracyEvaluator::GetPercentile (double percentile) const
+  {
+    if (m_samples == 0)
+      {
+	return 0;
+      }
+    uint64_t rank = static_cast<uint64_t> (std::ceil (percentile / 100 * m_samples));
+    rank = std::max<uint64_t> (rank, 1);
+    uint64_t seen = 0;
+    for (uint32_t bin = 0; bin < kNBins; bin++)
+      {
+	seen += m_bins[bin];
+	if (seen >= rank)
+	  {
+	    return std::min (UpperEdge (bin), m_max);
+	  }
+      }
+    return m_max;
+  }
+
+  void
+  TrackingAccuracyEvaluator::Report (std::ostream &os, std::string label) const
+  {
+    os << label << " tracking error: " << m_samples << " samples (" << m_unknown << " unknown), mean "
+       << GetMean () << " m, p50 " << GetPercentile (50) << " m, p90 " << GetPercentile (90) << " m, p95 "
+       << GetPercentile (95) << " m, p99 " << GetPercentile (99) << " m, max " << m_max << " m" << std::endl;
+  }
+}
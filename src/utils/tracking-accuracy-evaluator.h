@@ -0,0 +1,121 @@
+#ifndef SUMOTRACEEXAMPLE_TRACKING_ACCURACY_EVALUATOR_H_
+#define SUMOTRACEEXAMPLE_TRACKING_ACCURACY_EVALUATOR_H_
+
+#include "trace-position-oracle.h"
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/vector.h"
+
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+  /**
+   * Measures how far a tracking server's view of the vehicles is from where
+   * they actually are. At a fixed interval, every node that carries a
+   * vehicle is looked up in the ground truth (TracePositionOracle) and in
+   * the server, and the distance between both goes into a histogram. A
+   * vehicle that has not reported since it entered counts as unknown, even
+   * if the server still holds a report from a vehicle that had the same id
+   * before it.
+   *
+   * The histogram has logarithmic bins 1% wide starting at 1 cm, so memory
+   * does not grow with the number of samples and percentiles are exact to
+   * within 1%.
+   */
+  class TrackingAccuracyEvaluator : public SimpleRefCount<TrackingAccuracyEvaluator>
+  {
+  public:
+    /**
+     * Asks the server where it believes a node is.
+     * \param id of the node, as given to AddNode
+     * \param position filled in with the estimate
+     * \param received filled in with when the report behind the estimate arrived
+     * \return false if the server knows nothing about the node yet
+     */
+    typedef Callback<bool, uint32_t, Vector &, Time &> EstimateCallback;
+
+    /**
+     * \param oracle with the true positions of the trace vehicles
+     * \param estimate callback into the server
+     */
+    TrackingAccuracyEvaluator (Ptr<const TracePositionOracle> oracle, EstimateCallback estimate);
+    /**
+     * Follows a node.
+     * \param id the server knows the node by, e.g. Node::GetId for servers
+     * that tell clients apart by their address, or the vehicle id for
+     * servers that are told it
+     * \param vehicles trace ids of the vehicles played by the node, in order of entry
+     */
+    void AddNode (uint32_t id, const std::vector<uint32_t> &vehicles);
+    /**
+     * Samples every interval, starting now.
+     * \param interval between samples
+     * \param stop time of the last sample
+     */
+    void Start (Time interval, Time stop);
+
+    /**
+     * \return the number of samples where the server had an estimate
+     */
+    uint64_t GetNSamples () const;
+    /**
+     * \return the number of samples where a vehicle was present but the
+     * server had no estimate for it
+     */
+    uint64_t GetNUnknown () const;
+    /**
+     * \return the mean error in meters
+     */
+    double GetMean () const;
+    /**
+     * \return the largest error in meters
+     */
+    double GetMax () const;
+    /**
+     * \param percentile between 0 and 100
+     * \return the error in meters below which that share of the samples fall
+     */
+    double GetPercentile (double percentile) const;
+    /**
+     * Prints the sample counts, the mean, p50, p90, p95, p99 and the maximum
+     * on one line.
+     * \param os stream to print to
+     * \param label naming the strategy being evaluated
+     */
+    void Report (std::ostream &os, std::string label) const;
+
+  private:
+    struct TrackedNode
+    {
+      uint32_t id;
+      std::vector<uint32_t> vehicles;
+      std::size_t current; /**< vehicle of the latest sample */
+    };
+
+    void Sample (void);
+    void Add (double error);
+
+    Ptr<const TracePositionOracle> m_oracle;
+    EstimateCallback m_estimate;
+    std::vector<TrackedNode> m_nodes;
+    Time m_interval;
+    Time m_stop;
+    EventId m_sampleEvent;
+
+    std::vector<uint64_t> m_bins; /**< error histogram */
+    uint64_t m_samples;
+    uint64_t m_unknown;
+    double m_sum;
+    double m_max;
+  };
+}
+
+#endif